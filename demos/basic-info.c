@@ -89,6 +89,7 @@ main(void)
     char *bad_func = NULL;
     char *cbindstr = NULL, *cbindstr2 = NULL, *cbindstr3 = NULL;
     int bound = 0, bound2 = 0, bound3 = 0;
+    QUO_info_t qinfo;
     QUO_context quo = NULL;
     inf_t info;
 
@@ -132,6 +133,11 @@ main(void)
         bad_func = "QUO_nnodes";
         goto out;
     }
+    /* or grab all of the scalar facts at once */
+    if (QUO_SUCCESS != (qrc = QUO_query_all(quo, &qinfo))) {
+        bad_func = "QUO_query_all";
+        goto out;
+    }
     /* last argument ignored with QUO_BIND_PUSH_OBJ option */
     if (QUO_SUCCESS != (qrc = QUO_bind_push(quo, QUO_BIND_PUSH_OBJ,
                                             QUO_OBJ_CORE, 0))) {
@@ -168,6 +174,12 @@ main(void)
     printf("### nsockets: %d\n", nsockets);
     printf("### ncores: %d\n", ncores);
     printf("### npus: %d\n", npus);
+    printf("### QUO_query_all agrees: %s\n",
+           (qinfo.nnodes == nnodes && qinfo.nqids == nnoderanks &&
+            qinfo.nobjs[QUO_OBJ_SOCKET] == nsockets &&
+            qinfo.nobjs[QUO_OBJ_CORE] == ncores &&
+            qinfo.nobjs[QUO_OBJ_PU] == npus &&
+            qinfo.bound == bound) ? "yes" : "no");
     printf("### process %d [%s] bound: %s\n",
            (int)getpid(), cbindstr, bound ? "true" : "false");
     printf("### process %d [%s] bound: %s\n",
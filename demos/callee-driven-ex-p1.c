@@ -96,6 +96,7 @@ static int
 sys_grok(p1_context_t *c)
 {
     char *bad_func = NULL;
+    QUO_info_t info;
 
     /* this interface is more powerful, but the other n* calls can be more
      * convenient. at any rate, this is an example of the
@@ -110,35 +111,20 @@ sys_grok(p1_context_t *c)
         bad_func = "QUO_nobjs_in_type_by_type";
         goto out;
     }
-    if (QUO_SUCCESS != QUO_ncores(c->quo, &c->ncores)) {
-        bad_func = "QUO_ncores";
-        goto out;
-    }
-    if (QUO_SUCCESS != QUO_npus(c->quo, &c->npus)) {
-        bad_func = "QUO_npus";
-        goto out;
-    }
-    if (QUO_SUCCESS != QUO_bound(c->quo, &c->bound)) {
-        bad_func = "QUO_bound";
-        goto out;
-    }
-    if (QUO_SUCCESS != QUO_nnodes(c->quo, &c->nnodes)) {
-        bad_func = "QUO_nnodes";
-        goto out;
-    }
-    if (QUO_SUCCESS != QUO_nqids(c->quo, &c->nnoderanks)) {
-        bad_func = "QUO_nqids";
-        goto out;
-    }
-    if (QUO_SUCCESS != QUO_id(c->quo, &c->noderank)) {
-        bad_func = "QUO_id";
-        goto out;
-    }
-    /* for NUMA nodes */
-    if (QUO_SUCCESS != QUO_nnumanodes(c->quo, &c->nnumanodes)) {
-        bad_func = "QUO_nnumanodes";
+    /* one call gets us everything else that the individual n* calls (e.g.,
+     * QUO_ncores, QUO_bound) would, without paying for their individual
+     * checks. */
+    if (QUO_SUCCESS != QUO_query_all(c->quo, &info)) {
+        bad_func = "QUO_query_all";
         goto out;
     }
+    c->nnumanodes = info.nobjs[QUO_OBJ_NUMANODE];
+    c->ncores = info.nobjs[QUO_OBJ_CORE];
+    c->npus = info.nobjs[QUO_OBJ_PU];
+    c->bound = info.bound;
+    c->nnodes = info.nnodes;
+    c->nnoderanks = info.nqids;
+    c->noderank = info.qid;
 out:
     if (bad_func) {
         fprintf(stderr, "%s: %s failure :-(\n", __func__, bad_func);
@@ -59,7 +59,10 @@ program quofort
     integer(c_int) nres, qid
     integer(c_int) cwrank
     integer(c_int), allocatable, dimension(:) :: sock_qids
+    integer(c_int), allocatable, dimension(:) :: qid_buf
+    type(quo_qid_mask_t) qmask
     type(c_ptr) quoc
+    type(quo_info_t) qinfo
     integer machine_comm
 
     call quo_version(ver, subver, info)
@@ -108,6 +111,21 @@ program quofort
     call quo_id(quoc, qid, info)
     print *, 'qid', qid
 
+    ! all of the above (and more) in one call
+    call quo_query_all(quoc, qinfo, info)
+    print *, 'query_all nobjs', qinfo%nobjs
+    print *, 'query_all nnodes, nqids, qid, bound', &
+             qinfo%nnodes, qinfo%nqids, qinfo%qid, qinfo%bound
+
+    ! allocation-free qids queries
+    allocate (qid_buf(qinfo%nqids))
+    call quo_qids_in_type_buf(quoc, QUO_OBJ_SOCKET, 0, qid_buf, nres, info)
+    print *, 'sock_qids (buf)', qid_buf(1:nres)
+    deallocate (qid_buf)
+
+    call quo_qids_in_type_mask(quoc, QUO_OBJ_SOCKET, 0, qmask, info)
+    print *, 'nsock_qids (mask)', quo_qid_mask_popcount(qmask)
+
     if (qid == 0) then
         print *, 'hello from qid 0!'
     endif
@@ -67,6 +67,24 @@ private:
   Context const &m_ctx;
 };
 
+/**
+ * @brief RAII wrapper for memory binding.
+ *
+ * This class binds memory to the NUMA nodes of the current binding on
+ * construction and makes sure that it is popped on scope exit.
+ */
+class MembindGuard {
+public:
+  explicit MembindGuard(Context const &ctx, int flags = MEMBIND_NONE)
+      : m_ctx(ctx) {
+    ctx.membind_push(flags);
+  }
+  ~MembindGuard() { m_ctx.membind_pop(); }
+
+private:
+  Context const &m_ctx;
+};
+
 } /* namespace quo */
 
 #endif
@@ -55,13 +55,21 @@ QUO_obj_type_t map_to_quo(ObjectType type) {
   case ObjectType::MACHINE:
     return QUO_OBJ_MACHINE;
   case ObjectType::NODE:
-    return QUO_OBJ_NODE;
+    return QUO_OBJ_NUMANODE;
   case ObjectType::SOCKET:
     return QUO_OBJ_SOCKET;
   case ObjectType::CORE:
     return QUO_OBJ_CORE;
   case ObjectType::PROCESSING_UNIT:
     return QUO_OBJ_PU;
+  case ObjectType::L1CACHE:
+    return QUO_OBJ_L1CACHE;
+  case ObjectType::L2CACHE:
+    return QUO_OBJ_L2CACHE;
+  case ObjectType::L3CACHE:
+    return QUO_OBJ_L3CACHE;
+  case ObjectType::GROUP:
+    return QUO_OBJ_GROUP;
   }
 }
 
@@ -73,6 +81,17 @@ QUO_bind_push_policy_t map_to_quo(BindPushPolicy policy) {
     return QUO_BIND_PUSH_OBJ;
   }
 }
+
+QUO_smt_policy_t map_to_quo(SmtPolicy policy) {
+  switch (policy) {
+  case SmtPolicy::CORES_FIRST:
+    return QUO_SMT_CORES_FIRST;
+  case SmtPolicy::ONE_PU_PER_CORE:
+    return QUO_SMT_ONE_PU_PER_CORE;
+  case SmtPolicy::SIBLINGS:
+    return QUO_SMT_SIBLINGS;
+  }
+}
 }
 
 struct Context::Impl {
@@ -125,6 +144,36 @@ std::vector<int> Context::qids_in_type(ObjectType type, int index) const {
   return std::vector<int>(p, p + n_quids);
 }
 
+void Context::qids_in_type(ObjectType type, int index,
+                           std::vector<int> &qids) const {
+  int n_quids{0};
+
+  const int max_quids{nqids()};
+
+  qids.resize(static_cast<size_t>(max_quids));
+  QUO_CXX_HANDLE_ERROR(QUO_qids_in_type_buf(m_impl->ctx, map_to_quo(type),
+                                            index, max_quids, &n_quids,
+                                            qids.data()));
+  qids.resize(static_cast<size_t>(n_quids));
+}
+
+QidMask Context::qids_in_type_mask(ObjectType type, int index) const {
+  static_assert(QidMask().size() == QUO_QID_MASK_NBITS,
+                "QidMask must match QUO_qid_mask_t");
+  QUO_qid_mask_t qmask;
+  QidMask mask;
+
+  QUO_CXX_HANDLE_ERROR(
+      QUO_qids_in_type_mask(m_impl->ctx, map_to_quo(type), index, &qmask));
+
+  for (int qid = QUO_qid_mask_next(&qmask, -1); qid != -1;
+       qid = QUO_qid_mask_next(&qmask, qid)) {
+    mask.set(static_cast<size_t>(qid));
+  }
+
+  return mask;
+}
+
 int Context::nnumanodes() const {
   int nnumanodes{0};
 
@@ -199,10 +248,62 @@ void Context::bind_push(BindPushPolicy policy, ObjectType type,
       QUO_bind_push(m_impl->ctx, map_to_quo(policy), map_to_quo(type), index));
 }
 
+void Context::bind_push_cpuset(const std::string &cpuset) const {
+  QUO_CXX_HANDLE_ERROR(QUO_bind_push_cpuset(m_impl->ctx, cpuset.c_str()));
+}
+
+void Context::bind_push_objs(
+    const std::vector<std::pair<ObjectType, int>> &objs) const {
+  std::vector<QUO_obj_type_t> types;
+  std::vector<int> indices;
+
+  for (auto const &obj : objs) {
+    types.push_back(map_to_quo(obj.first));
+    indices.push_back(obj.second);
+  }
+  QUO_CXX_HANDLE_ERROR(QUO_bind_push_objs(m_impl->ctx, types.data(),
+                                          indices.data(),
+                                          static_cast<int>(objs.size())));
+}
+
 void Context::bind_pop() const {
   QUO_CXX_HANDLE_ERROR(QUO_bind_pop(m_impl->ctx));
 }
 
+void Context::set_smt_policy(SmtPolicy policy) const {
+  QUO_CXX_HANDLE_ERROR(QUO_set_smt_policy(m_impl->ctx, map_to_quo(policy)));
+}
+
+void Context::bind_thread(int tid, int nthreads) const {
+  QUO_CXX_HANDLE_ERROR(QUO_bind_thread(m_impl->ctx, tid, nthreads));
+}
+
+void Context::membind_push(int flags) const {
+  QUO_CXX_HANDLE_ERROR(QUO_membind_push(m_impl->ctx, flags));
+}
+
+void Context::membind_pop() const {
+  QUO_CXX_HANDLE_ERROR(QUO_membind_pop(m_impl->ctx));
+}
+
+void Context::membind_register(const void *buf, std::size_t nbytes) const {
+  QUO_CXX_HANDLE_ERROR(QUO_membind_register(m_impl->ctx, buf, nbytes));
+}
+
+void Context::membind_unregister(const void *buf) const {
+  QUO_CXX_HANDLE_ERROR(QUO_membind_unregister(m_impl->ctx, buf));
+}
+
+std::pair<std::size_t, double> Context::membind_migrate_stats() const {
+  std::size_t nbytes{0};
+  double seconds{0.0};
+
+  QUO_CXX_HANDLE_ERROR(
+      QUO_membind_migrate_stats(m_impl->ctx, &nbytes, &seconds));
+
+  return {nbytes, seconds};
+}
+
 bool Context::auto_distrib(ObjectType distrib_over_this,
                            int max_qids_per_res_type) const {
   int selected{0};
@@ -214,4 +315,140 @@ bool Context::auto_distrib(ObjectType distrib_over_this,
   return (selected != 0);
 }
 
+int Context::auto_distrib_assign(ObjectType distrib_over_this,
+                                 int max_qids_per_res_type, int flags) const {
+  int selected{0};
+  int res_index{-1};
+
+  QUO_CXX_HANDLE_ERROR(QUO_auto_distrib_assign(
+      m_impl->ctx, map_to_quo(distrib_over_this), max_qids_per_res_type,
+      &selected, &res_index, flags));
+
+  return res_index;
+}
+
+int Context::auto_distrib_weighted(ObjectType distrib_over_this,
+                                   int max_qids_per_res_type, double cost,
+                                   int flags) const {
+  int selected{0};
+  int res_index{-1};
+
+  QUO_CXX_HANDLE_ERROR(QUO_auto_distrib_weighted(
+      m_impl->ctx, map_to_quo(distrib_over_this), max_qids_per_res_type, cost,
+      &selected, &res_index, flags));
+
+  return res_index;
+}
+
+int Context::auto_distrib_hier(const std::vector<ObjectType> &levels,
+                               const std::vector<int> &maxes,
+                               int flags) const {
+  if (levels.size() != maxes.size()) {
+    throw std::invalid_argument("levels and maxes differ in size");
+  }
+  std::vector<QUO_obj_type_t> quo_levels;
+  for (auto level : levels) {
+    quo_levels.push_back(map_to_quo(level));
+  }
+  int selected{0};
+  int leaf_index{-1};
+
+  QUO_CXX_HANDLE_ERROR(QUO_auto_distrib_hier(
+      m_impl->ctx, quo_levels.data(), maxes.data(),
+      static_cast<int>(levels.size()), &selected, &leaf_index, flags));
+
+  return leaf_index;
+}
+
+std::vector<int> Context::auto_distrib_get_map() const {
+  std::vector<int> map(nqids());
+
+  QUO_CXX_HANDLE_ERROR(QUO_auto_distrib_get_map(m_impl->ctx, map.data()));
+
+  return map;
+}
+
+void Context::node_bcast(void *buffer, size_t nbytes, int root_qid) const {
+  QUO_CXX_HANDLE_ERROR(QUO_node_bcast(m_impl->ctx, buffer, nbytes, root_qid));
+}
+
+void Context::node_allreduce(const void *sendbuf, void *recvbuf, int count,
+                             MPI_Datatype datatype, MPI_Op op) const {
+  QUO_CXX_HANDLE_ERROR(
+      QUO_node_allreduce(m_impl->ctx, sendbuf, recvbuf, count, datatype, op));
+}
+
+void Context::node_allgather(const void *sendbuf, size_t nbytes,
+                             void *recvbuf) const {
+  QUO_CXX_HANDLE_ERROR(
+      QUO_node_allgather(m_impl->ctx, sendbuf, nbytes, recvbuf));
+}
+
+MPI_Comm Context::leader_comm(ObjectType type) const {
+  MPI_Comm comm{MPI_COMM_NULL};
+
+  QUO_CXX_HANDLE_ERROR(
+      QUO_get_leader_comm(m_impl->ctx, map_to_quo(type), &comm));
+
+  return comm;
+}
+
+Info Context::query_all() const {
+  static_assert(std::tuple_size<decltype(Info::nobjs)>::value ==
+                    sizeof(QUO_info_t::nobjs) / sizeof(QUO_info_t::nobjs[0]),
+                "Info::nobjs must match QUO_info_t::nobjs");
+  QUO_info_t qinfo;
+
+  QUO_CXX_HANDLE_ERROR(QUO_query_all(m_impl->ctx, &qinfo));
+
+  Info info;
+  for (size_t i = 0; i < info.nobjs.size(); ++i) {
+    info.nobjs[i] = qinfo.nobjs[i];
+  }
+  info.nnodes = qinfo.nnodes;
+  info.nqids = qinfo.nqids;
+  info.qid = qinfo.qid;
+  info.bound = (qinfo.bound != 0);
+  for (int pu = 0; pu < 64 * QUO_INFO_CPUSET_NWORDS; ++pu) {
+    if (qinfo.cpuset[pu / 64] & (UINT64_C(1) << (pu % 64))) {
+      info.cpuset.push_back(pu);
+    }
+  }
+
+  return info;
+}
+
+Placement Context::global_place(ObjectType res_type, int nactive,
+                                int flags) const {
+  QUO_placement_t qplacement;
+
+  QUO_CXX_HANDLE_ERROR(QUO_global_place(m_impl->ctx, map_to_quo(res_type),
+                                        nactive, flags, &qplacement));
+
+  Placement placement;
+  placement.active = (qplacement.active != 0);
+  placement.nactive_on_node = qplacement.nactive_on_node;
+  placement.nactive = qplacement.nactive;
+  placement.res_index = qplacement.res_index;
+  placement.nthreads = qplacement.nthreads;
+
+  return placement;
+}
+
+void Context::phase_report(int phase_id, double seconds) const {
+  QUO_CXX_HANDLE_ERROR(QUO_phase_report(m_impl->ctx, phase_id, seconds));
+}
+
+int Context::rebalance(ObjectType res_type, int phase_id,
+                       int &max_qids_per_res_type, int flags) const {
+  int selected{0};
+  int res_index{-1};
+
+  QUO_CXX_HANDLE_ERROR(QUO_rebalance(m_impl->ctx, map_to_quo(res_type),
+                                     phase_id, &max_qids_per_res_type,
+                                     &selected, &res_index, flags));
+
+  return res_index;
+}
+
 } /* namespace quo */
@@ -44,8 +44,10 @@
 #ifndef QUO_CXX_CONTEXT_HPP
 #define QUO_CXX_CONTEXT_HPP
 
+#include <cstddef>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "mpi.h"
@@ -94,6 +96,17 @@ public:
    */
   std::vector<int> qids_in_type(ObjectType type, int index) const;
 
+  /**
+   * @brief Like above, but reuses the storage of qids (no allocation once its
+   * capacity reaches nqids()).
+   */
+  void qids_in_type(ObjectType type, int index, std::vector<int> &qids) const;
+
+  /**
+   * @brief qids in a specific object as a fixed-size mask.
+   */
+  QidMask qids_in_type_mask(ObjectType type, int index) const;
+
   /**
    * @brief Number of NUMA nodes on the system of the caller.
    */
@@ -136,11 +149,58 @@ public:
    */
   void bind_push(BindPushPolicy policy, ObjectType type, int index) const;
 
+  /**
+   * @brief Set new binding to an explicit cpuset (list or mask format).
+   */
+  void bind_push_cpuset(const std::string &cpuset) const;
+
+  /**
+   * @brief Set new binding to the union of the given (type, index) objects.
+   */
+  void
+  bind_push_objs(const std::vector<std::pair<ObjectType, int>> &objs) const;
+
   /**
    * @brief Return to last binding.
    */
   void bind_pop() const;
 
+  /**
+   * @brief Set how bindings treat SMT siblings.
+   */
+  void set_smt_policy(SmtPolicy policy) const;
+
+  /**
+   * @brief Bind the calling thread (tid of nthreads) within the current
+   * binding.
+   */
+  void bind_thread(int tid, int nthreads) const;
+
+  /**
+   * @brief Bind memory to the NUMA nodes of the current binding.
+   */
+  void membind_push(int flags = MEMBIND_NONE) const;
+
+  /**
+   * @brief Return to last memory binding.
+   */
+  void membind_pop() const;
+
+  /**
+   * @brief Register a buffer to move on MEMBIND_MIGRATE binding changes.
+   */
+  void membind_register(const void *buf, std::size_t nbytes) const;
+
+  /**
+   * @brief Remove a buffer added by membind_register.
+   */
+  void membind_unregister(const void *buf) const;
+
+  /**
+   * @brief Bytes moved and seconds taken by the last migrating change.
+   */
+  std::pair<std::size_t, double> membind_migrate_stats() const;
+
   /**
    * @brief Local barrier.
    */
@@ -154,6 +214,87 @@ public:
   bool auto_distrib(ObjectType distrib_over_this,
                     int max_qids_per_res_type) const;
 
+  /**
+   * @brief Like auto_distrib, but also optionally binds (see AutoDistribFlags).
+   *
+   * @return Index of the resource the caller was assigned, -1 if not selected.
+   */
+  int auto_distrib_assign(ObjectType distrib_over_this,
+                          int max_qids_per_res_type,
+                          int flags = AUTO_DISTRIB_NONE) const;
+
+  /**
+   * @brief Load-aware auto_distrib_assign (node-local collective).
+   *
+   * @return Index of the resource the caller was assigned, -1 if not selected.
+   */
+  int auto_distrib_weighted(ObjectType distrib_over_this,
+                            int max_qids_per_res_type, double cost,
+                            int flags = AUTO_DISTRIB_NONE) const;
+
+  /**
+   * @brief Nested distribution: levels[i] resources get at most maxes[i] qids.
+   *
+   * @return Index of the leaf resource the caller was assigned, -1 if not
+   * selected.
+   */
+  int auto_distrib_hier(const std::vector<ObjectType> &levels,
+                        const std::vector<int> &maxes,
+                        int flags = AUTO_DISTRIB_NONE) const;
+
+  /**
+   * @brief Node-wide map of the latest assignment: element qid is the
+   * resource index assigned to qid, -1 if not selected.
+   */
+  std::vector<int> auto_distrib_get_map() const;
+
+  /**
+   * @brief Node-local broadcast of nbytes from root_qid's buffer.
+   */
+  void node_bcast(void *buffer, size_t nbytes, int root_qid) const;
+
+  /**
+   * @brief Node-local allreduce of count elements.
+   */
+  void node_allreduce(const void *sendbuf, void *recvbuf, int count,
+                      MPI_Datatype datatype, MPI_Op op) const;
+
+  /**
+   * @brief Node-local allgather of nbytes per qid (recvbuf is in qid order).
+   */
+  void node_allgather(const void *sendbuf, size_t nbytes, void *recvbuf) const;
+
+  /**
+   * @brief Cached leader communicator (one rank per object of type).
+   *
+   * Owned by the context; do not free. MPI_COMM_NULL for non-leaders.
+   */
+  MPI_Comm leader_comm(ObjectType type) const;
+
+  /**
+   * @brief Everything libquo knows about the caller in one call.
+   */
+  Info query_all() const;
+
+  /**
+   * @brief Job-wide placement of nactive active processes.
+   */
+  Placement global_place(ObjectType res_type, int nactive,
+                         int flags = AUTO_DISTRIB_NONE) const;
+
+  /**
+   * @brief Records how long the caller spent in one instance of a phase.
+   */
+  void phase_report(int phase_id, double seconds) const;
+
+  /**
+   * @brief Feedback-driven auto_distrib_assign; updates max_qids_per_res_type.
+   *
+   * @return Index of the resource the caller was assigned, -1 if not selected.
+   */
+  int rebalance(ObjectType res_type, int phase_id, int &max_qids_per_res_type,
+                int flags = AUTO_DISTRIB_NONE) const;
+
 private:
   struct Impl;
   std::unique_ptr<Impl> m_impl;
@@ -44,6 +44,10 @@
 #ifndef QUO_CXX_TYPES_HPP
 #define QUO_CXX_TYPES_HPP
 
+#include <array>
+#include <bitset>
+#include <vector>
+
 namespace quo {
 
 /**
@@ -65,7 +69,15 @@ enum class ObjectType {
   /** core */
   CORE,
   /** processing unit (e.g. hardware thread) */
-  PROCESSING_UNIT
+  PROCESSING_UNIT,
+  /** level 1 data (or unified) cache */
+  L1CACHE,
+  /** level 2 data (or unified) cache */
+  L2CACHE,
+  /** level 3 data (or unified) cache */
+  L3CACHE,
+  /** innermost level of hwloc groups */
+  GROUP
 };
 
 /**
@@ -75,6 +87,78 @@ enum class ObjectType {
  */
 enum class BindPushPolicy { PROVIDED = 0, OBJECT };
 
+/**
+ * @brief Corresponds to QUO_smt_policy_t.
+ *
+ * A detailed documentation can be found in libquo.
+ */
+enum class SmtPolicy { CORES_FIRST = 0, ONE_PU_PER_CORE, SIBLINGS };
+
+/**
+ * @brief Corresponds to QUO_auto_distrib_flags_t. Unscoped so values can be
+ * combined with |.
+ */
+enum AutoDistribFlags {
+  AUTO_DISTRIB_NONE = 0x0,
+  AUTO_DISTRIB_BIND = 0x1,
+  AUTO_DISTRIB_MIN_MIGRATION = 0x4
+};
+
+/**
+ * @brief Corresponds to QUO_membind_flags_t. Unscoped so values can be
+ * combined with |.
+ */
+enum MembindFlags {
+  MEMBIND_NONE = 0x0,
+  MEMBIND_STRICT = 0x1,
+  MEMBIND_MIGRATE = 0x2
+};
+
+/**
+ * @brief Corresponds to QUO_qid_mask_t: bit qid is set if qid is in the set.
+ */
+using QidMask = std::bitset<1024>;
+
+/**
+ * @brief Corresponds to QUO_info_t.
+ *
+ * A detailed documentation can be found in libquo.
+ */
+struct Info {
+  /** number of objects of each type, indexed by ObjectType */
+  std::array<int, 9> nobjs;
+  /** number of compute nodes in the job */
+  int nnodes;
+  /** number of qids on this machine */
+  int nqids;
+  /** qid of the caller */
+  int qid;
+  /** whether or not the caller is bound */
+  bool bound;
+  /** OS indices of the PUs in the caller's current binding */
+  std::vector<int> cpuset;
+
+  int count(ObjectType type) const { return nobjs[static_cast<int>(type)]; }
+};
+
+/**
+ * @brief Corresponds to QUO_placement_t.
+ *
+ * A detailed documentation can be found in libquo.
+ */
+struct Placement {
+  /** whether or not the caller is active */
+  bool active;
+  /** number of active qids on this machine */
+  int nactive_on_node;
+  /** number of active processes in the job */
+  int nactive;
+  /** resource the caller's binding is intended for, -1 if not active */
+  int res_index;
+  /** number of threads the caller should run, 0 if not active */
+  int nthreads;
+};
+
 } /* namespace quo */
 
 #endif
@@ -64,6 +64,18 @@ std::ostream &operator<<(std::ostream &out, ObjectType const &type) {
   case ObjectType::PROCESSING_UNIT:
     out << "PROCESSING_UNIT";
     break;
+  case ObjectType::L1CACHE:
+    out << "L1CACHE";
+    break;
+  case ObjectType::L2CACHE:
+    out << "L2CACHE";
+    break;
+  case ObjectType::L3CACHE:
+    out << "L3CACHE";
+    break;
+  case ObjectType::GROUP:
+    out << "GROUP";
+    break;
   }
 
   return out;
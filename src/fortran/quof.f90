@@ -80,12 +80,20 @@ module quo
       integer(c_int) QUO_OBJ_SOCKET
       integer(c_int) QUO_OBJ_CORE
       integer(c_int) QUO_OBJ_PU
+      integer(c_int) QUO_OBJ_L1CACHE
+      integer(c_int) QUO_OBJ_L2CACHE
+      integer(c_int) QUO_OBJ_L3CACHE
+      integer(c_int) QUO_OBJ_GROUP
 
       parameter (QUO_OBJ_MACHINE = 0)
       parameter (QUO_OBJ_NUMANODE = 1)
       parameter (QUO_OBJ_SOCKET = 2)
       parameter (QUO_OBJ_CORE = 3)
       parameter (QUO_OBJ_PU = 4)
+      parameter (QUO_OBJ_L1CACHE = 5)
+      parameter (QUO_OBJ_L2CACHE = 6)
+      parameter (QUO_OBJ_L3CACHE = 7)
+      parameter (QUO_OBJ_GROUP = 8)
 
       !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
       ! push policies
@@ -96,6 +104,85 @@ module quo
       parameter (QUO_BIND_PUSH_PROVIDED = 0)
       parameter (QUO_BIND_PUSH_OBJ = 1)
 
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      ! SMT policies
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      integer(c_int) QUO_SMT_CORES_FIRST
+      integer(c_int) QUO_SMT_ONE_PU_PER_CORE
+      integer(c_int) QUO_SMT_SIBLINGS
+
+      parameter (QUO_SMT_CORES_FIRST = 0)
+      parameter (QUO_SMT_ONE_PU_PER_CORE = 1)
+      parameter (QUO_SMT_SIBLINGS = 2)
+
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      ! memory bind flags (may be combined with ior)
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      integer(c_int) QUO_MEMBIND_NONE
+      integer(c_int) QUO_MEMBIND_STRICT
+      integer(c_int) QUO_MEMBIND_MIGRATE
+
+      parameter (QUO_MEMBIND_NONE = 0)
+      parameter (QUO_MEMBIND_STRICT = 1)
+      parameter (QUO_MEMBIND_MIGRATE = 2)
+
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      ! auto distrib flags (may be combined with ior)
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      integer(c_int) QUO_AUTO_DISTRIB_NONE
+      integer(c_int) QUO_AUTO_DISTRIB_BIND
+      integer(c_int) QUO_AUTO_DISTRIB_MIN_MIGRATION
+
+      parameter (QUO_AUTO_DISTRIB_NONE = 0)
+      parameter (QUO_AUTO_DISTRIB_BIND = 1)
+      parameter (QUO_AUTO_DISTRIB_MIN_MIGRATION = 4)
+
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      ! number of distinct phase ids
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      integer(c_int) QUO_MAX_PHASES
+
+      parameter (QUO_MAX_PHASES = 16)
+
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      ! qid masks (mirrors QUO_qid_mask_t)
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      integer(c_int) QUO_QID_MASK_NBITS
+
+      parameter (QUO_QID_MASK_NBITS = 1024)
+
+      type, bind(c) :: quo_qid_mask_t
+          integer(c_int64_t) :: bits(QUO_QID_MASK_NBITS / 64)
+      end type quo_qid_mask_t
+
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      ! quo_query_all results (mirrors QUO_info_t)
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      integer(c_int) QUO_INFO_CPUSET_NWORDS
+
+      parameter (QUO_INFO_CPUSET_NWORDS = 16)
+
+      type, bind(c) :: quo_info_t
+          ! indexed by quo object type
+          integer(c_int) :: nobjs(0:QUO_OBJ_GROUP)
+          integer(c_int) :: nnodes
+          integer(c_int) :: nqids
+          integer(c_int) :: qid
+          integer(c_int) :: bound
+          integer(c_int64_t) :: cpuset(QUO_INFO_CPUSET_NWORDS)
+      end type quo_info_t
+
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      ! quo_global_place results (mirrors QUO_placement_t)
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      type, bind(c) :: quo_placement_t
+          integer(c_int) :: active
+          integer(c_int) :: nactive_on_node
+          integer(c_int) :: nactive
+          integer(c_int) :: res_index
+          integer(c_int) :: nthreads
+      end type quo_placement_t
+
 interface
 !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
       integer(c_int) &
@@ -304,6 +391,32 @@ interface
       end function quo_bind_push_c
 end interface
 
+!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+interface
+      integer(c_int) &
+      function quo_bind_push_cpuset_c(q, cpuset_str) &
+          bind(c, name='QUO_bind_push_cpuset')
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int, c_char
+          implicit none
+          type(c_ptr), value :: q
+          character(kind=c_char), intent(in) :: cpuset_str(*)
+      end function quo_bind_push_cpuset_c
+end interface
+
+!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+interface
+      integer(c_int) &
+      function quo_bind_push_objs_c(q, types, obj_indices, nobjs) &
+          bind(c, name='QUO_bind_push_objs')
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), intent(in) :: types(*)
+          integer(c_int), intent(in) :: obj_indices(*)
+          integer(c_int), value :: nobjs
+      end function quo_bind_push_objs_c
+end interface
+
 !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 interface
       integer(c_int) &
@@ -315,6 +428,93 @@ interface
       end function quo_bind_pop_c
 end interface
 
+!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+interface
+      integer(c_int) &
+      function quo_set_smt_policy_c(q, policy) &
+          bind(c, name='QUO_set_smt_policy')
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), value :: policy
+      end function quo_set_smt_policy_c
+end interface
+
+!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+interface
+      integer(c_int) &
+      function quo_bind_thread_c(q, tid, nthreads) &
+          bind(c, name='QUO_bind_thread')
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), value :: tid
+          integer(c_int), value :: nthreads
+      end function quo_bind_thread_c
+end interface
+
+!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+interface
+      integer(c_int) &
+      function quo_membind_push_c(q, flags) &
+          bind(c, name='QUO_membind_push')
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), value :: flags
+      end function quo_membind_push_c
+end interface
+
+!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+interface
+      integer(c_int) &
+      function quo_membind_pop_c(q) &
+          bind(c, name='QUO_membind_pop')
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+      end function quo_membind_pop_c
+end interface
+
+!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+interface
+      integer(c_int) &
+      function quo_membind_register_c(q, buf, nbytes) &
+          bind(c, name='QUO_membind_register')
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int, c_size_t
+          implicit none
+          type(c_ptr), value :: q
+          type(c_ptr), value :: buf
+          integer(c_size_t), value :: nbytes
+      end function quo_membind_register_c
+end interface
+
+!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+interface
+      integer(c_int) &
+      function quo_membind_unregister_c(q, buf) &
+          bind(c, name='QUO_membind_unregister')
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          type(c_ptr), value :: buf
+      end function quo_membind_unregister_c
+end interface
+
+!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+interface
+      integer(c_int) &
+      function quo_membind_migrate_stats_c(q, nbytes, seconds) &
+          bind(c, name='QUO_membind_migrate_stats')
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int, c_size_t, &
+                                                 c_double
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_size_t), intent(out) :: nbytes
+          real(c_double), intent(out) :: seconds
+      end function quo_membind_migrate_stats_c
+end interface
+
 !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 interface
       integer(c_int) &
@@ -354,6 +554,286 @@ interface
       end function quo_get_mpi_comm_by_type_c
 end interface
 
+!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+interface
+      integer(c_int) &
+      function quo_node_bcast_c(q, buffer, nbytes, root_qid) &
+          bind(c, name='QUO_node_bcast')
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int, c_size_t
+          implicit none
+          type(c_ptr), value :: q
+          type(c_ptr), value :: buffer
+          integer(c_size_t), value :: nbytes
+          integer(c_int), value :: root_qid
+      end function quo_node_bcast_c
+end interface
+
+!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+interface
+      integer(c_int) &
+      function quo_node_allreduce_c(q, sendbuf, recvbuf, count, &
+                                    datatype, op) &
+          bind(c, name='QUO_node_allreduce_f2c')
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          type(c_ptr), value :: sendbuf, recvbuf
+          integer(c_int), value :: count
+          integer(c_int), value :: datatype, op
+      end function quo_node_allreduce_c
+end interface
+
+!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+interface
+      integer(c_int) &
+      function quo_node_allgather_c(q, sendbuf, nbytes, recvbuf) &
+          bind(c, name='QUO_node_allgather')
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int, c_size_t
+          implicit none
+          type(c_ptr), value :: q
+          type(c_ptr), value :: sendbuf
+          integer(c_size_t), value :: nbytes
+          type(c_ptr), value :: recvbuf
+      end function quo_node_allgather_c
+end interface
+
+!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+interface
+      integer(c_int) &
+      function quo_get_leader_comm_c(q, obj_type, comm) &
+          bind(c, name='QUO_get_leader_comm_f2c')
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), value :: obj_type
+          integer(c_int), intent(out):: comm
+      end function quo_get_leader_comm_c
+end interface
+
+!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+interface
+      integer(c_int) &
+      function quo_query_all_c(q, qinfo) &
+          bind(c, name='QUO_query_all')
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          import :: quo_info_t
+          implicit none
+          type(c_ptr), value :: q
+          type(quo_info_t), intent(out) :: qinfo
+      end function quo_query_all_c
+end interface
+
+!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+interface
+      integer(c_int) &
+      function quo_qids_in_type_buf_c(q, obj_type, type_index, &
+                                      max_qids, onqids, qids) &
+          bind(c, name='QUO_qids_in_type_buf')
+          use, intrinsic :: iso_c_binding, only: c_int, c_ptr
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), value :: obj_type, type_index, max_qids
+          integer(c_int), intent(out) :: onqids
+          integer(c_int), intent(out) :: qids(*)
+      end function quo_qids_in_type_buf_c
+end interface
+
+!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+interface
+      integer(c_int) &
+      function quo_qids_in_type_mask_c(q, obj_type, type_index, mask) &
+          bind(c, name='QUO_qids_in_type_mask')
+          use, intrinsic :: iso_c_binding, only: c_int, c_ptr
+          import :: quo_qid_mask_t
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), value :: obj_type, type_index
+          type(quo_qid_mask_t), intent(out) :: mask
+      end function quo_qids_in_type_mask_c
+end interface
+
+!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+! qid mask operations are called directly.
+interface
+      subroutine quo_qid_mask_zero(mask) &
+          bind(c, name='QUO_qid_mask_zero')
+          import :: quo_qid_mask_t
+          implicit none
+          type(quo_qid_mask_t), intent(out) :: mask
+      end subroutine quo_qid_mask_zero
+
+      subroutine quo_qid_mask_set(mask, qid) &
+          bind(c, name='QUO_qid_mask_set')
+          use, intrinsic :: iso_c_binding, only: c_int
+          import :: quo_qid_mask_t
+          implicit none
+          type(quo_qid_mask_t), intent(inout) :: mask
+          integer(c_int), value :: qid
+      end subroutine quo_qid_mask_set
+
+      integer(c_int) &
+      function quo_qid_mask_isset(mask, qid) &
+          bind(c, name='QUO_qid_mask_isset')
+          use, intrinsic :: iso_c_binding, only: c_int
+          import :: quo_qid_mask_t
+          implicit none
+          type(quo_qid_mask_t), intent(in) :: mask
+          integer(c_int), value :: qid
+      end function quo_qid_mask_isset
+
+      subroutine quo_qid_mask_and(omask, a, b) &
+          bind(c, name='QUO_qid_mask_and')
+          import :: quo_qid_mask_t
+          implicit none
+          type(quo_qid_mask_t), intent(inout) :: omask
+          type(quo_qid_mask_t), intent(in) :: a, b
+      end subroutine quo_qid_mask_and
+
+      subroutine quo_qid_mask_or(omask, a, b) &
+          bind(c, name='QUO_qid_mask_or')
+          import :: quo_qid_mask_t
+          implicit none
+          type(quo_qid_mask_t), intent(inout) :: omask
+          type(quo_qid_mask_t), intent(in) :: a, b
+      end subroutine quo_qid_mask_or
+
+      integer(c_int) &
+      function quo_qid_mask_popcount(mask) &
+          bind(c, name='QUO_qid_mask_popcount')
+          use, intrinsic :: iso_c_binding, only: c_int
+          import :: quo_qid_mask_t
+          implicit none
+          type(quo_qid_mask_t), intent(in) :: mask
+      end function quo_qid_mask_popcount
+
+      integer(c_int) &
+      function quo_qid_mask_next(mask, prev_qid) &
+          bind(c, name='QUO_qid_mask_next')
+          use, intrinsic :: iso_c_binding, only: c_int
+          import :: quo_qid_mask_t
+          implicit none
+          type(quo_qid_mask_t), intent(in) :: mask
+          integer(c_int), value :: prev_qid
+      end function quo_qid_mask_next
+end interface
+
+!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+interface
+      integer(c_int) &
+      function quo_auto_distrib_assign_c(q, distrib_over_this, &
+                                         max_qids_per_res_type, &
+                                         oselected, ores_index, flags) &
+          bind(c, name='QUO_auto_distrib_assign')
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), value :: distrib_over_this
+          integer(c_int), value :: max_qids_per_res_type
+          integer(c_int), intent(out) :: oselected
+          integer(c_int), intent(out) :: ores_index
+          integer(c_int), value :: flags
+      end function quo_auto_distrib_assign_c
+end interface
+
+!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+interface
+      integer(c_int) &
+      function quo_auto_distrib_get_map_c(q, omap) &
+          bind(c, name='QUO_auto_distrib_get_map')
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), intent(out) :: omap(*)
+      end function quo_auto_distrib_get_map_c
+end interface
+
+!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+interface
+      integer(c_int) &
+      function quo_auto_distrib_weighted_c(q, distrib_over_this, &
+                                           max_qids_per_res_type, cost, &
+                                           oselected, ores_index, flags) &
+          bind(c, name='QUO_auto_distrib_weighted')
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int, c_double
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), value :: distrib_over_this
+          integer(c_int), value :: max_qids_per_res_type
+          real(c_double), value :: cost
+          integer(c_int), intent(out) :: oselected
+          integer(c_int), intent(out) :: ores_index
+          integer(c_int), value :: flags
+      end function quo_auto_distrib_weighted_c
+end interface
+
+!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+interface
+      integer(c_int) &
+      function quo_auto_distrib_hier_c(q, levels, &
+                                       max_qids_per_res_type, nlevels, &
+                                       oselected, oleaf_index, flags) &
+          bind(c, name='QUO_auto_distrib_hier')
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), intent(in) :: levels(*)
+          integer(c_int), intent(in) :: max_qids_per_res_type(*)
+          integer(c_int), value :: nlevels
+          integer(c_int), intent(out) :: oselected
+          integer(c_int), intent(out) :: oleaf_index
+          integer(c_int), value :: flags
+      end function quo_auto_distrib_hier_c
+end interface
+
+!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+interface
+      integer(c_int) &
+      function quo_global_place_c(q, res_type, nactive, flags, &
+                                  placement) &
+          bind(c, name='QUO_global_place')
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          import :: quo_placement_t
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), value :: res_type
+          integer(c_int), value :: nactive
+          integer(c_int), value :: flags
+          type(quo_placement_t), intent(out) :: placement
+      end function quo_global_place_c
+end interface
+
+!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+interface
+      integer(c_int) &
+      function quo_phase_report_c(q, phase_id, seconds) &
+          bind(c, name='QUO_phase_report')
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int, c_double
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), value :: phase_id
+          real(c_double), value :: seconds
+      end function quo_phase_report_c
+end interface
+
+!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+interface
+      integer(c_int) &
+      function quo_rebalance_c(q, res_type, phase_id, &
+                               max_qids_per_res_type, oselected, &
+                               ores_index, flags) &
+          bind(c, name='QUO_rebalance')
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), value :: res_type
+          integer(c_int), value :: phase_id
+          integer(c_int), intent(inout) :: max_qids_per_res_type
+          integer(c_int), intent(out) :: oselected
+          integer(c_int), intent(out) :: ores_index
+          integer(c_int), value :: flags
+      end function quo_rebalance_c
+end interface
+
 !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 !interface
 !      integer(c_int) &
@@ -390,7 +870,7 @@ contains
           use, intrinsic :: iso_c_binding, only: c_ptr, c_int
           implicit none
           type(c_ptr), intent(out) :: q
-          integer, value :: comm
+          integer(c_int), value :: comm
           integer(c_int), intent(out) :: ierr
           ierr = quo_create_c(q, comm)
       end subroutine quo_create
@@ -545,6 +1025,28 @@ contains
           ierr = quo_bind_push_c(q, policy, obj_type, obj_index)
       end subroutine quo_bind_push
 
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      subroutine quo_bind_push_cpuset(q, cpuset_str, ierr)
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int, c_null_char
+          implicit none
+          type(c_ptr), value :: q
+          character(len=*), intent(in) :: cpuset_str
+          integer(c_int), intent(out) :: ierr
+          ierr = quo_bind_push_cpuset_c(q, trim(cpuset_str) // c_null_char)
+      end subroutine quo_bind_push_cpuset
+
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      subroutine quo_bind_push_objs(q, types, obj_indices, nobjs, ierr)
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), intent(in) :: types(*)
+          integer(c_int), intent(in) :: obj_indices(*)
+          integer(c_int), value :: nobjs
+          integer(c_int), intent(out) :: ierr
+          ierr = quo_bind_push_objs_c(q, types, obj_indices, nobjs)
+      end subroutine quo_bind_push_objs
+
       !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
       subroutine quo_bind_pop(q, ierr)
           use, intrinsic :: iso_c_binding, only: c_ptr, c_int
@@ -554,6 +1056,81 @@ contains
           ierr = quo_bind_pop_c(q)
       end subroutine quo_bind_pop
 
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      subroutine quo_set_smt_policy(q, policy, ierr)
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), value :: policy
+          integer(c_int), intent(out) :: ierr
+          ierr = quo_set_smt_policy_c(q, policy)
+      end subroutine quo_set_smt_policy
+
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      ! tid is base 0 (e.g. omp_get_thread_num())
+      subroutine quo_bind_thread(q, tid, nthreads, ierr)
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), value :: tid
+          integer(c_int), value :: nthreads
+          integer(c_int), intent(out) :: ierr
+          ierr = quo_bind_thread_c(q, tid, nthreads)
+      end subroutine quo_bind_thread
+
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      subroutine quo_membind_push(q, flags, ierr)
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), value :: flags
+          integer(c_int), intent(out) :: ierr
+          ierr = quo_membind_push_c(q, flags)
+      end subroutine quo_membind_push
+
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      subroutine quo_membind_pop(q, ierr)
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), intent(out) :: ierr
+          ierr = quo_membind_pop_c(q)
+      end subroutine quo_membind_pop
+
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      ! buf is the c_loc of the (target) buffer
+      subroutine quo_membind_register(q, buf, nbytes, ierr)
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int, c_size_t
+          implicit none
+          type(c_ptr), value :: q
+          type(c_ptr), value :: buf
+          integer(c_size_t), value :: nbytes
+          integer(c_int), intent(out) :: ierr
+          ierr = quo_membind_register_c(q, buf, nbytes)
+      end subroutine quo_membind_register
+
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      subroutine quo_membind_unregister(q, buf, ierr)
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          type(c_ptr), value :: buf
+          integer(c_int), intent(out) :: ierr
+          ierr = quo_membind_unregister_c(q, buf)
+      end subroutine quo_membind_unregister
+
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      subroutine quo_membind_migrate_stats(q, nbytes, seconds, ierr)
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int, c_size_t, &
+                                                 c_double
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_size_t), intent(out) :: nbytes
+          real(c_double), intent(out) :: seconds
+          integer(c_int), intent(out) :: ierr
+          ierr = quo_membind_migrate_stats_c(q, nbytes, seconds)
+      end subroutine quo_membind_migrate_stats
+
       !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
       subroutine quo_barrier(q, ierr)
           use, intrinsic :: iso_c_binding, only: c_ptr, c_int
@@ -586,11 +1163,218 @@ contains
           implicit none
           type(c_ptr), value :: q
           integer(c_int), value :: target_type
-          integer, intent(out) :: comm
+          integer(c_int), intent(out) :: comm
           integer(c_int), intent(out) :: ierr
           ierr = quo_get_mpi_comm_by_type_c(q, target_type, comm)
       end subroutine quo_get_mpi_comm_by_type
 
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      subroutine quo_node_bcast(q, buffer, nbytes, root_qid, ierr)
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int, c_size_t
+          implicit none
+          type(c_ptr), value :: q
+          type(c_ptr), value :: buffer
+          integer(c_size_t), value :: nbytes
+          integer(c_int), value :: root_qid
+          integer(c_int), intent(out) :: ierr
+          ierr = quo_node_bcast_c(q, buffer, nbytes, root_qid)
+      end subroutine quo_node_bcast
+
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      subroutine quo_node_allreduce(q, sendbuf, recvbuf, count, &
+                                    datatype, op, ierr)
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          type(c_ptr), value :: sendbuf, recvbuf
+          integer(c_int), value :: count
+          integer(c_int), value :: datatype, op
+          integer(c_int), intent(out) :: ierr
+          ierr = quo_node_allreduce_c(q, sendbuf, recvbuf, count, &
+                                      datatype, op)
+      end subroutine quo_node_allreduce
+
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      subroutine quo_node_allgather(q, sendbuf, nbytes, recvbuf, ierr)
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int, c_size_t
+          implicit none
+          type(c_ptr), value :: q
+          type(c_ptr), value :: sendbuf
+          integer(c_size_t), value :: nbytes
+          type(c_ptr), value :: recvbuf
+          integer(c_int), intent(out) :: ierr
+          ierr = quo_node_allgather_c(q, sendbuf, nbytes, recvbuf)
+      end subroutine quo_node_allgather
+
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      subroutine quo_get_leader_comm(q, obj_type, comm, ierr)
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), value :: obj_type
+          integer(c_int), intent(out) :: comm
+          integer(c_int), intent(out) :: ierr
+          ierr = quo_get_leader_comm_c(q, obj_type, comm)
+      end subroutine quo_get_leader_comm
+
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      subroutine quo_query_all(q, qinfo, ierr)
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          type(quo_info_t), intent(out) :: qinfo
+          integer(c_int), intent(out) :: ierr
+          ierr = quo_query_all_c(q, qinfo)
+      end subroutine quo_query_all
+
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      subroutine quo_qids_in_type_buf(q, obj_type, type_index, qids, &
+                                      nqids, ierr)
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), value :: obj_type, type_index
+          ! must be able to hold quo_nqids entries
+          integer(c_int), intent(out) :: qids(:)
+          integer(c_int), intent(out) :: nqids
+          integer(c_int), intent(out) :: ierr
+          ierr = quo_qids_in_type_buf_c(q, obj_type, type_index, &
+                                        size(qids), nqids, qids)
+      end subroutine quo_qids_in_type_buf
+
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      subroutine quo_qids_in_type_mask(q, obj_type, type_index, mask, ierr)
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), value :: obj_type, type_index
+          type(quo_qid_mask_t), intent(out) :: mask
+          integer(c_int), intent(out) :: ierr
+          ierr = quo_qids_in_type_mask_c(q, obj_type, type_index, mask)
+      end subroutine quo_qids_in_type_mask
+
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      subroutine quo_auto_distrib_assign(q, distrib_over_this, &
+                                         max_qids_per_res_type, &
+                                         oselected, ores_index, flags, &
+                                         ierr)
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), value :: distrib_over_this
+          integer(c_int), value :: max_qids_per_res_type
+          integer(c_int) :: iselected
+          logical, intent(out) :: oselected
+          integer(c_int), intent(out) :: ores_index
+          integer(c_int), value :: flags
+          integer(c_int), intent(out) :: ierr
+          ierr = quo_auto_distrib_assign_c(q, distrib_over_this, &
+                                           max_qids_per_res_type, &
+                                           iselected, ores_index, flags)
+          oselected = (iselected == 1)
+      end subroutine quo_auto_distrib_assign
+
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      ! omap(qid + 1) is the resource index assigned to qid (or -1)
+      subroutine quo_auto_distrib_get_map(q, omap, ierr)
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), intent(out) :: omap(*)
+          integer(c_int), intent(out) :: ierr
+          ierr = quo_auto_distrib_get_map_c(q, omap)
+      end subroutine quo_auto_distrib_get_map
+
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      subroutine quo_auto_distrib_weighted(q, distrib_over_this, &
+                                           max_qids_per_res_type, cost, &
+                                           oselected, ores_index, flags, &
+                                           ierr)
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int, c_double
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), value :: distrib_over_this
+          integer(c_int), value :: max_qids_per_res_type
+          real(c_double), value :: cost
+          integer(c_int) :: iselected
+          logical, intent(out) :: oselected
+          integer(c_int), intent(out) :: ores_index
+          integer(c_int), value :: flags
+          integer(c_int), intent(out) :: ierr
+          ierr = quo_auto_distrib_weighted_c(q, distrib_over_this, &
+                                             max_qids_per_res_type, cost, &
+                                             iselected, ores_index, flags)
+          oselected = (iselected == 1)
+      end subroutine quo_auto_distrib_weighted
+
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      subroutine quo_auto_distrib_hier(q, levels, &
+                                       max_qids_per_res_type, nlevels, &
+                                       oselected, oleaf_index, flags, &
+                                       ierr)
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), intent(in) :: levels(*)
+          integer(c_int), intent(in) :: max_qids_per_res_type(*)
+          integer(c_int), value :: nlevels
+          integer(c_int) :: iselected
+          logical, intent(out) :: oselected
+          integer(c_int), intent(out) :: oleaf_index
+          integer(c_int), value :: flags
+          integer(c_int), intent(out) :: ierr
+          ierr = quo_auto_distrib_hier_c(q, levels, &
+                                         max_qids_per_res_type, nlevels, &
+                                         iselected, oleaf_index, flags)
+          oselected = (iselected == 1)
+      end subroutine quo_auto_distrib_hier
+
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      subroutine quo_global_place(q, res_type, nactive, flags, &
+                                  placement, ierr)
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), value :: res_type
+          integer(c_int), value :: nactive
+          integer(c_int), value :: flags
+          type(quo_placement_t), intent(out) :: placement
+          integer(c_int), intent(out) :: ierr
+          ierr = quo_global_place_c(q, res_type, nactive, flags, placement)
+      end subroutine quo_global_place
+
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      subroutine quo_phase_report(q, phase_id, seconds, ierr)
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int, c_double
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), value :: phase_id
+          real(c_double), value :: seconds
+          integer(c_int), intent(out) :: ierr
+          ierr = quo_phase_report_c(q, phase_id, seconds)
+      end subroutine quo_phase_report
+
+      !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+      subroutine quo_rebalance(q, res_type, phase_id, &
+                               max_qids_per_res_type, oselected, &
+                               ores_index, flags, ierr)
+          use, intrinsic :: iso_c_binding, only: c_ptr, c_int
+          implicit none
+          type(c_ptr), value :: q
+          integer(c_int), value :: res_type
+          integer(c_int), value :: phase_id
+          integer(c_int), intent(inout) :: max_qids_per_res_type
+          integer(c_int) :: iselected
+          logical, intent(out) :: oselected
+          integer(c_int), intent(out) :: ores_index
+          integer(c_int), value :: flags
+          integer(c_int), intent(out) :: ierr
+          ierr = quo_rebalance_c(q, res_type, phase_id, &
+                                 max_qids_per_res_type, iselected, &
+                                 ores_index, flags)
+          oselected = (iselected == 1)
+      end subroutine quo_rebalance
+
       !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
       !subroutine quo_bind_threads(q, type, index, ierr)
       !    use, intrinsic :: iso_c_binding, only: c_int
@@ -52,8 +52,7 @@
 #include "quo.h"
 #include "quo-private.h"
 #include "quo-set.h"
-#include "quo-mpi.h"
-#include "quo-sm.h"
+#include "quo-hwloc.h"
 
 #ifdef HAVE_STDLIB_H
 #include <stdlib.h>
@@ -67,8 +66,15 @@
 #ifdef HAVE_STRING_H
 #include <string.h>
 #endif
+#ifdef HAVE_FLOAT_H
+#include <float.h>
+#endif
 
 /**
+ * Builds the qid-to-resource table straight from the node-wide affinity table,
+ * so no communication is required. rank_ids_in_res rows point into a single
+ * buffer that is stored at rank_ids_in_res[0].
+ *
  * \note Caller is responsible for freeing returned resources.
  */
 static int
@@ -85,188 +91,367 @@ get_qids_in_target_type(QUO_t *q,
     *out_nranks_in_res = NULL;
     *out_rank_ids_in_res = NULL;
 
-    int *nranks_in_res = NULL;
+    int *nranks_in_res = NULL, *tab = NULL;
     int **rank_ids_in_res = NULL;
-    int rc = QUO_ERR;
-    /* Communication structures. */
-    MPI_Comm node_comm;
-    /* Points to a unique (node-local) path name for inter-process affinity
-     * info. */
-    char *sm_seg_path = NULL;
-    quo_sm_t *smseg = NULL;
-
-    /* Get node communicator so we can chat with our friends. */
-    if (QUO_SUCCESS != (rc = quo_mpi_get_node_comm(q->mpi, &node_comm))) {
-        QUO_ERR_MSGRC("quo_mpi_get_node_comm", rc);
-        goto out;
-    }
-    /* Generate and agree upon a unique (node-local) path name. */
-    if (QUO_SUCCESS != (rc = quo_mpi_xchange_uniq_path(q->mpi,
-                                                       "qaff",
-                                                       &sm_seg_path))) {
-        QUO_ERR_MSGRC("quo_mpi_xchange_uniq_path", rc);
-        goto out;
-    }
-    /* Build the shared-memory instance. */
-    if (QUO_SUCCESS != (rc = quo_sm_construct(&smseg))) {
-        QUO_ERR_MSGRC("quo_sm_construct", rc);
-        goto out;
-    }
-    /* Allocate some memory for our arrays. */
+    int rc = QUO_SUCCESS;
+
     nranks_in_res = calloc(n_target, sizeof(*nranks_in_res));
-    if (!nranks_in_res) {
-        QUO_OOR_COMPLAIN();
-        rc = QUO_ERR_OOR;
-        goto out;
-    }
-    /* Allocate pointer array. */
     rank_ids_in_res = calloc(n_target, sizeof(*rank_ids_in_res));
-    if (!rank_ids_in_res) {
+    tab = calloc((size_t)n_target * q->nqid, sizeof(*tab));
+    if (!nranks_in_res || !rank_ids_in_res || !tab) {
         QUO_OOR_COMPLAIN();
         rc = QUO_ERR_OOR;
         goto out;
     }
-    /* Let one process query for QUO_qids_in_type info that will then be shared
-     * via shared-memory. */
-    if (0 == q->qid) {
-        /* Query for the smp ranks (node ranks) that cover each resource. */
-        for (int rid = 0; rid < n_target; ++rid) {
-            rc = QUO_qids_in_type(q, target, rid,
-                                  &(nranks_in_res[rid]),
-                                  &(rank_ids_in_res[rid]));
-            if (QUO_SUCCESS != rc) goto out;
-        }
-        /* Now that we have that info, now calculate how large of a
-         * shared-memory segment is needed (in bytes). */
-        int sm_seg_len = 0;
-        const int header_len = (n_target * sizeof(*nranks_in_res));
-        /* The first bit will be the "header" info. */
-        sm_seg_len += header_len;
-        /* The next bit will be dedicated to the rank_ids_in_res table. We have
-         * enough information in the header to reconstruct the table, which we
-         * are going to store as a flatten 1D array in the shared-memory
-         * segment. */
-        int num_entries = 0;
-        for (int i = 0; i < n_target; ++i) {
-            num_entries += nranks_in_res[i];
-        }
-        sm_seg_len += (num_entries * sizeof(*nranks_in_res));
-        /* Now that we know the size of the buffer, share that info. */
-        if (QUO_SUCCESS != (rc = quo_mpi_bcast(&sm_seg_len, 1,
-                                               MPI_INT, 0, node_comm))) {
-            QUO_ERR_MSGRC("quo_mpi_bcast", rc);
-            goto out;
-        }
-        /* Create the shared-memory segment. */
-        if (QUO_SUCCESS != (rc = quo_sm_segment_create(smseg,
-                                                       sm_seg_path,
-                                                       sm_seg_len))) {
-            QUO_ERR_MSGRC("quo_sm_segment_create", rc);
+    for (int rid = 0; rid < n_target; ++rid) {
+        rank_ids_in_res[rid] = tab + ((size_t)rid * q->nqid);
+        rc = quo_hwloc_qids_in_type(q->hwloc, target, rid,
+                                    &(nranks_in_res[rid]),
+                                    rank_ids_in_res[rid]);
+        if (QUO_SUCCESS != rc) {
+            QUO_ERR_MSGRC("quo_hwloc_qids_in_type", rc);
             goto out;
         }
-        /* Get base of the shared-memory segment (starting point for header). */
-        char *headerp = (char *)quo_sm_get_basep(smseg);
-        /* Fill in the header. */
-        (void)memmove(headerp, nranks_in_res, header_len);
-        /* Copy a flattened version of the rank_ids_in_res table into the
-         * shared-memory segment. Note that the tabular data starting point is
-         * offset by header_len bytes. */
-        char *tabp = (headerp + header_len);
-        for (int i = 0; i < n_target; ++i) {
-            const size_t nbytes = nranks_in_res[i] * sizeof(*nranks_in_res);
-            (void)memmove(tabp, rank_ids_in_res[i], nbytes);
-            tabp += nbytes;
-        }
-        /* Signal completion. */
-        if (QUO_SUCCESS != (rc = quo_mpi_sm_barrier(q->mpi))) {
-            QUO_ERR_MSGRC("quo_mpi_sm_barrier", rc);
-            goto out;
-        }
-        /* Wait for attach completion. */
-        if (QUO_SUCCESS != (rc = quo_mpi_sm_barrier(q->mpi))) {
-            QUO_ERR_MSGRC("quo_mpi_sm_barrier", rc);
-            goto out;
-        }
-        /* Cleanup after everyone is done. */
-        (void)quo_sm_unlink(smseg);
+    }
+out:
+    if (QUO_SUCCESS != rc) {
+        if (tab) free(tab);
+        if (rank_ids_in_res) free(rank_ids_in_res);
+        if (nranks_in_res) free(nranks_in_res);
     }
     else {
-        int sm_seg_len = 0;
-        /* Get shared-memory segment size. */
-        if (QUO_SUCCESS != (rc = quo_mpi_bcast(&sm_seg_len, 1,
-                                               MPI_INT, 0, node_comm))) {
-            QUO_ERR_MSGRC("quo_mpi_bcast", rc);
-            goto out;
+        *out_nranks_in_res = nranks_in_res;
+        *out_rank_ids_in_res = rank_ids_in_res;
+    }
+    return rc;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Returns the memo entry for the given arguments that was calculated against
+ * the given binding digests (one per qid), or NULL if there is none.
+ */
+static quo_auto_distrib_memo_t *
+memo_lookup(QUO_t *q,
+            QUO_obj_type_t res_type,
+            int max_qids_per_res_type,
+            bool min_migration,
+            const uint64_t *digests)
+{
+    for (int i = 0; i < QUO_AUTO_DISTRIB_MEMO_LEN; ++i) {
+        quo_auto_distrib_memo_t *m = &q->ad_memo[i];
+        if (m->valid && m->res_type == (int)res_type &&
+            m->max_qids_per_res_type == max_qids_per_res_type &&
+            m->min_migration == min_migration &&
+            0 == memcmp(m->digests, digests, q->nqid * sizeof(*digests))) {
+            return m;
         }
-        /* Wait for the data to be published. */
-        if (QUO_SUCCESS != (rc = quo_mpi_sm_barrier(q->mpi))) {
-            QUO_ERR_MSGRC("quo_mpi_sm_barrier", rc);
-            goto out;
+    }
+    return NULL;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Returns the memo entry to fill in for the given arguments. It only becomes
+ * valid once its map has been filled in. Every process on the node claims
+ * entries in the same order, so all memos stay alike.
+ */
+static quo_auto_distrib_memo_t *
+memo_claim(QUO_t *q,
+           QUO_obj_type_t res_type,
+           int max_qids_per_res_type,
+           bool min_migration,
+           const uint64_t *digests)
+{
+    const int i = q->ad_memo_next;
+    quo_auto_distrib_memo_t *m = &q->ad_memo[i];
+
+    q->ad_memo_next = (q->ad_memo_next + 1) % QUO_AUTO_DISTRIB_MEMO_LEN;
+    m->valid = false;
+    m->res_type = (int)res_type;
+    m->max_qids_per_res_type = max_qids_per_res_type;
+    m->min_migration = min_migration;
+    m->digests = q->ad_memo_digests + ((size_t)i * q->nqid);
+    (void)memcpy(m->digests, digests, q->nqid * sizeof(*digests));
+    m->map = q->ad_memo_maps + ((size_t)i * q->nqid);
+    return m;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Returns the largest of the return codes of the node-local processes, so that
+ * a process that failed on its own (e.g., ran out of memory) takes everyone
+ * else out of the next collective with it instead of leaving them waiting.
+ */
+static int
+node_worst_rc(QUO_t *q,
+              int rc)
+{
+    int worst = QUO_SUCCESS;
+    const int arc = QUO_node_allreduce(q, &rc, &worst, 1, MPI_INT, MPI_MAX);
+
+    return (QUO_SUCCESS != arc) ? arc : worst;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Shares the node-wide map that qid 0 calculated, so that every process acts
+ * on the same snapshot of the affinity table. rc is qid 0's return code for
+ * the calculation and everyone else's for their own preparations. If anyone
+ * failed, all return the largest error code instead of waiting on each other.
+ */
+static int
+share_map(QUO_t *q,
+          int rc,
+          int *map)
+{
+    if (QUO_SUCCESS != (rc = node_worst_rc(q, rc))) return rc;
+    return QUO_node_bcast(q, map, (size_t)q->nqid * sizeof(*map), 0);
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Returns the index of the resource assigned to the given qid or -1 if the qid
+ * wasn't selected. shared[qid] is true if qid is in the k set intersection.
+ */
+static int
+assign_qid(int qid,
+           int nqids,
+           int nres,
+           const int *nranks_in_res,
+           int **rank_ids_in_res,
+           const bool *shared,
+           int k_set_intersection_len,
+           int max_qids_per_res_type)
+{
+    /* !!! remember: always maintain "max workers per resource" invariant !!! */
+
+    /* completely disjoint sets, so making a local decision is easy */
+    if (0 == k_set_intersection_len) {
+        for (int rid = 0; rid < nres; ++rid) {
+            for (int rank = 0; rank < nranks_in_res[rid]; ++rank) {
+                /* if my current cpuset covers the resource in question and
+                 * someone won't be assigned to that particular resource */
+                if (qid == rank_ids_in_res[rid][rank] &&
+                    rank < max_qids_per_res_type) {
+                    return rid;
+                }
+            }
         }
-        if (QUO_SUCCESS!= (rc = quo_sm_segment_attach(smseg,
-                                                      sm_seg_path,
-                                                      sm_seg_len))) {
-            QUO_ERR_MSGRC("quo_sm_segment_attach", rc);
-            goto out;
+        return -1;
+    }
+    /* all processes overlap - really no hope of doing anything sane. we
+     * typically see this in the "no one is bound case." deal the selected
+     * ones out round-robin so no resource gets more than its share. */
+    if (nqids == k_set_intersection_len) {
+        if (qid < max_qids_per_res_type * nres) return qid % nres;
+        return -1;
+    }
+    /* only a few ranks share a resource. i don't know if this case will ever
+     * happen in practice, but i've seen stranger things... in any case, favor
+     * unshared resources. */
+    for (int rid = 0; rid < nres; ++rid) {
+        int rmapped = 0;
+        for (int rank = 0; rank < nranks_in_res[rid]; ++rank) {
+            /* this thing is shared - skip */
+            if (shared[rank_ids_in_res[rid][rank]]) continue;
+            /* if my current cpuset covers the resource in question */
+            if (qid == rank_ids_in_res[rid][rank] &&
+                rmapped < max_qids_per_res_type) {
+                return rid;
+            }
+            ++rmapped;
         }
-        /* Signal attach attach completion. */
-        if (QUO_SUCCESS != (rc = quo_mpi_sm_barrier(q->mpi))) {
-            QUO_ERR_MSGRC("quo_mpi_sm_barrier", rc);
-            goto out;
+    }
+    return -1;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Remembers the node-wide map of the latest assignment (see
+ * QUO_auto_distrib_get_map).
+ */
+static int
+keep_map(QUO_t *q,
+         const int *map)
+{
+    if (!q->ad_map) {
+        if (NULL == (q->ad_map = calloc(q->nqid, sizeof(*q->ad_map)))) {
+            QUO_OOR_COMPLAIN();
+            return QUO_ERR_OOR;
         }
-        /* Reconstruct structures to pass to caller. */
-        /* Get base of the shared-memory segment (starting point for header). */
-        char *headerp = (char *)quo_sm_get_basep(smseg);
-        /* Get first bit of info from the header. */
-        const int header_len = (n_target * sizeof(*nranks_in_res));
-        (void)memmove(nranks_in_res, headerp, header_len);
-        /* Copy from a flattened version of the rank_ids_in_res table into the
-         * "real" 2D table that will be passed to the caller. */
-        char *tabp = (headerp + header_len);
-        for (int i = 0; i < n_target; ++i) {
-            const size_t nranks = nranks_in_res[i];
-            const size_t nbytes = nranks * sizeof(*nranks_in_res);
-            rank_ids_in_res[i] = calloc(nranks, sizeof(*nranks_in_res));
-            if (NULL == rank_ids_in_res[i]) {
-                QUO_OOR_COMPLAIN();
-                rc = QUO_ERR_OOR;
-                goto out;
-            }
-            /* Copy out. */
-            (void)memmove(rank_ids_in_res[i], tabp, nbytes);
-            tabp += nbytes;
+    }
+    (void)memcpy(q->ad_map, map, q->nqid * sizeof(*map));
+    return QUO_SUCCESS;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Solves the rectangular assignment problem with the Hungarian method in
+ * O(n^2 m): gives each of the n rows its own column out of m (n <= m) so that
+ * the summed cost is minimal. cost is n x m, row-major. out_col[i] is the
+ * column given to row i.
+ */
+static int
+min_cost_assign(int n,
+                int m,
+                const double *cost,
+                int *out_col)
+{
+    /* potentials and slack, 1-based with a virtual column 0 */
+    double *u = calloc(n + 1, sizeof(*u));
+    double *v = calloc(m + 1, sizeof(*v));
+    double *minv = calloc(m + 1, sizeof(*minv));
+    /* row matched to a column and the augmenting path */
+    int *p = calloc(m + 1, sizeof(*p));
+    int *way = calloc(m + 1, sizeof(*way));
+    bool *used = calloc(m + 1, sizeof(*used));
+    int rc = QUO_SUCCESS;
+
+    if (!u || !v || !minv || !p || !way || !used) {
+        QUO_OOR_COMPLAIN();
+        rc = QUO_ERR_OOR;
+        goto out;
+    }
+    for (int i = 1; i <= n; ++i) {
+        int j0 = 0;
+        p[0] = i;
+        for (int j = 0; j <= m; ++j) {
+            minv[j] = DBL_MAX;
+            used[j] = false;
         }
+        do {
+            const int i0 = p[j0];
+            double delta = DBL_MAX;
+            int j1 = 0;
+            used[j0] = true;
+            for (int j = 1; j <= m; ++j) {
+                if (used[j]) continue;
+                const double cur = cost[(size_t)(i0 - 1) * m + (j - 1)] -
+                                   u[i0] - v[j];
+                if (cur < minv[j]) {
+                    minv[j] = cur;
+                    way[j] = j0;
+                }
+                if (minv[j] < delta) {
+                    delta = minv[j];
+                    j1 = j;
+                }
+            }
+            for (int j = 0; j <= m; ++j) {
+                if (used[j]) {
+                    u[p[j]] += delta;
+                    v[j] -= delta;
+                }
+                else minv[j] -= delta;
+            }
+            j0 = j1;
+        } while (0 != p[j0]);
+        /* flip the augmenting path */
+        do {
+            const int j1 = way[j0];
+            p[j0] = p[j1];
+            j0 = j1;
+        } while (0 != j0);
+    }
+    for (int j = 1; j <= m; ++j) {
+        if (0 != p[j]) out_col[p[j] - 1] = j - 1;
     }
 out:
-    if (QUO_SUCCESS != rc) {
-        if (rank_ids_in_res) {
-            for (int i = 0; i < n_target; ++i) {
-                if (rank_ids_in_res[i]) free(rank_ids_in_res[i]);
-            }
-            free(rank_ids_in_res);
+    if (u) free(u);
+    if (v) free(v);
+    if (minv) free(minv);
+    if (p) free(p);
+    if (way) free(way);
+    if (used) free(used);
+    return rc;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Minimum-migration assignment: matches qids to nslots slots, dealt out
+ * round-robin over the resources (so no resource gets more than
+ * ceil(nslots / nres)), such that as much of the qids' current bindings as
+ * possible stays put. A qid's cost for a slot is the fraction of its binding
+ * that lies outside the slot's resource. Every slot is filled when there are
+ * enough qids, and every qid gets a slot when there are enough slots. A tiny
+ * penalty on later slots of a resource spreads otherwise equal qids out.
+ *
+ * Only the nqids qids listed in qids (all of them if NULL) and the nres
+ * resources starting at res_first take part. out_assigned[i] is the resource
+ * given to the ith qid, or -1.
+ */
+static int
+min_migration_assign(QUO_t *q,
+                     QUO_obj_type_t res_type,
+                     int nslots,
+                     int nqids,
+                     const int *qids,
+                     int res_first,
+                     int nres,
+                     int *out_assigned)
+{
+    /* the smaller side picks from the larger one */
+    const bool qids_pick = (nqids <= nslots);
+    const int n = qids_pick ? nqids : nslots, m = qids_pick ? nslots : nqids;
+    double *outside = NULL, *cost = NULL;
+    int *col = NULL, rc = QUO_SUCCESS;
+
+    for (int i = 0; i < nqids; ++i) out_assigned[i] = -1;
+    if (0 == n) return QUO_SUCCESS;
+    outside = calloc((size_t)nqids * nres, sizeof(*outside));
+    cost = calloc((size_t)n * m, sizeof(*cost));
+    col = calloc(n, sizeof(*col));
+    if (!outside || !cost || !col) {
+        QUO_OOR_COMPLAIN();
+        rc = QUO_ERR_OOR;
+        goto out;
+    }
+    for (int i = 0; i < nqids; ++i) {
+        const int qid = qids ? qids[i] : i;
+        for (int rid = 0; rid < nres; ++rid) {
+            int noverlap = 0, nbound = 0;
+            rc = quo_hwloc_qid_overlap(q->hwloc, qid, res_type, res_first + rid,
+                                       &noverlap, &nbound);
+            if (QUO_SUCCESS != rc) goto out;
+            outside[(size_t)i * nres + rid] =
+                (0 == nbound) ? 1.0 : 1.0 - ((double)noverlap / nbound);
         }
-        if (nranks_in_res) free(nranks_in_res);
     }
-    else {
-        *out_nranks_in_res = nranks_in_res;
-        *out_rank_ids_in_res = rank_ids_in_res;
+    for (int slot = 0; slot < nslots; ++slot) {
+        const int rid = slot % nres;
+        const double penalty = 1e-6 * (slot / nres);
+        for (int i = 0; i < nqids; ++i) {
+            const double c = outside[(size_t)i * nres + rid] + penalty;
+            if (qids_pick) cost[(size_t)i * m + slot] = c;
+            else cost[(size_t)slot * m + i] = c;
+        }
     }
-    /* General cleanup. */
-    if (sm_seg_path) free(sm_seg_path);
-    (void)quo_sm_destruct(smseg);
-
+    if (QUO_SUCCESS != (rc = min_cost_assign(n, m, cost, col))) goto out;
+    for (int i = 0; i < n; ++i) {
+        if (qids_pick) out_assigned[i] = res_first + col[i] % nres;
+        else out_assigned[col[i]] = res_first + i % nres;
+    }
+out:
+    if (outside) free(outside);
+    if (cost) free(cost);
+    if (col) free(col);
     return rc;
 }
 
 /* ////////////////////////////////////////////////////////////////////////// */
-int
-QUO_auto_distrib(QUO_t *q,
-                 QUO_obj_type_t distrib_over_this,
-                 int max_qids_per_res_type,
-                 int *out_selected)
+/**
+ * Calculates the node-wide map (out_map[qid] is the resource index assigned to
+ * qid, or -1) from the node-wide affinity table.
+ */
+static int
+calc_map(QUO_t *q,
+         QUO_obj_type_t distrib_over_this,
+         int nres,
+         int max_qids_per_res_type,
+         bool min_migration,
+         int *out_map)
 {
-    /* total number of target resources. */
-    int nres = 0;
     /* points to an array that stores the number of elements in the
      * rank_ids_in_res array at a particular resource index. */
     int *nranks_in_res = NULL;
@@ -276,27 +461,16 @@ QUO_auto_distrib(QUO_t *q,
      */
     int **rank_ids_in_res = NULL;
     int rc = QUO_ERR;
-    /* my node (smp) rank */
-    int my_smp_rank = 0, nsmp_ranks = 0;
     /* holds k set intersection info */
     int *k_set_intersection = NULL, k_set_intersection_len = 0;
+    /* shared[qid] is true if qid shares a resource with someone else */
+    bool *shared = NULL;
 
-    if (!q || !out_selected || max_qids_per_res_type <= 0) {
-        return QUO_ERR_INVLD_ARG;
+    if (min_migration) {
+        return min_migration_assign(q, distrib_over_this,
+                                    nres * max_qids_per_res_type, q->nqid,
+                                    NULL, 0, nres, out_map);
     }
-    QUO_NO_INIT_ACTION(q);
-    *out_selected = 0; /* set default */
-    /* get total number of processes that share a node with me (includes me). */
-    nsmp_ranks = q->nqid;
-    /* what is my node rank? */
-    my_smp_rank = q->qid;
-    /* figure out how many target things are on the system. */
-    if (QUO_SUCCESS != (rc = QUO_nobjs_by_type(q, distrib_over_this,
-                                               &nres))) {
-        return rc;
-    }
-    /* if there are no resources, then return not found */
-    if (0 == nres) return QUO_ERR_NOT_FOUND;
     /* Populate arrays with data required to perform the intersection
      * calculation. */
     if (QUO_SUCCESS != (rc = get_qids_in_target_type(q, distrib_over_this, nres,
@@ -313,82 +487,687 @@ QUO_auto_distrib(QUO_t *q,
                                         &k_set_intersection,
                                         &k_set_intersection_len);
     if (QUO_SUCCESS != rc) goto out;
+    if (NULL == (shared = calloc(q->nqid, sizeof(*shared)))) {
+        QUO_OOR_COMPLAIN();
+        rc = QUO_ERR_OOR;
+        goto out;
+    }
+    for (int i = 0; i < k_set_intersection_len; ++i) {
+        shared[k_set_intersection[i]] = true;
+    }
     /* ////////////////////////////////////////////////////////////////////// */
     /* distribute workers over target resources. */
     /* ////////////////////////////////////////////////////////////////////// */
+    for (int qid = 0; qid < q->nqid; ++qid) {
+        out_map[qid] = assign_qid(qid, q->nqid, nres, nranks_in_res,
+                                  rank_ids_in_res, shared,
+                                  k_set_intersection_len,
+                                  max_qids_per_res_type);
+    }
+out:
+    /* the resources returned by get_qids_in_target_type must be freed by us */
+    if (rank_ids_in_res) {
+        free(rank_ids_in_res[0]);
+        free(rank_ids_in_res);
+    }
+    if (nranks_in_res) free(nranks_in_res);
+    if (k_set_intersection) free(k_set_intersection);
+    if (shared) free(shared);
 
-    /* !!! remember: always maintain "max workers per resource" invariant !!! */
+    return rc;
+}
 
-    /* completely disjoint sets, so making a local decision is easy */
-    if (0 == k_set_intersection_len) {
+/* ////////////////////////////////////////////////////////////////////////// */
+static int
+auto_distrib(QUO_t *q,
+             QUO_obj_type_t distrib_over_this,
+             int max_qids_per_res_type,
+             bool min_migration,
+             int *out_res_index)
+{
+    /* total number of target resources. */
+    int nres = 0;
+    int rc = QUO_ERR;
+    /* digest of my binding */
+    uint64_t digest = 0;
+    quo_auto_distrib_memo_t *memo = NULL;
+
+    *out_res_index = -1; /* set default */
+    /* figure out how many target things are on the system. */
+    if (QUO_SUCCESS != (rc = QUO_nobjs_by_type(q, distrib_over_this,
+                                               &nres))) {
+        return rc;
+    }
+    /* if there are no resources, then return not found */
+    if (0 == nres) return QUO_ERR_NOT_FOUND;
+    /* agree on the bindings. everyone contributes the digest of their own
+     * binding, which no one else can change and they won't change before the
+     * map is shared, so all see the same digests and make the same choice. */
+    if (QUO_SUCCESS != (rc = quo_hwloc_bind_digest(q->hwloc, &digest))) {
+        return rc;
+    }
+    if (QUO_SUCCESS != (rc = QUO_node_allgather(q, &digest, sizeof(digest),
+                                                q->ad_digests))) {
+        return rc;
+    }
+    /* everyone is bound like they were when we last answered this question
+     * (e.g., a push that was popped since), so the answer hasn't changed. */
+    memo = memo_lookup(q, distrib_over_this, max_qids_per_res_type,
+                       min_migration, q->ad_digests);
+    if (!memo) {
+        memo = memo_claim(q, distrib_over_this, max_qids_per_res_type,
+                          min_migration, q->ad_digests);
+        rc = QUO_SUCCESS;
+        if (0 == q->qid) {
+            rc = calc_map(q, distrib_over_this, nres, max_qids_per_res_type,
+                          min_migration, memo->map);
+        }
+        if (QUO_SUCCESS != (rc = share_map(q, rc, memo->map))) return rc;
+        memo->valid = true;
+    }
+    *out_res_index = memo->map[q->qid];
+    return keep_map(q, memo->map);
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_auto_distrib(QUO_t *q,
+                 QUO_obj_type_t distrib_over_this,
+                 int max_qids_per_res_type,
+                 int *out_selected)
+{
+    int rc = QUO_SUCCESS, res_index = -1;
+
+    if (!q || !out_selected || max_qids_per_res_type <= 0) {
+        return QUO_ERR_INVLD_ARG;
+    }
+    QUO_NO_INIT_ACTION(q);
+    *out_selected = 0; /* set default */
+    rc = auto_distrib(q, distrib_over_this, max_qids_per_res_type, false,
+                      &res_index);
+    if (QUO_SUCCESS != rc) return rc;
+    *out_selected = (-1 != res_index) ? 1 : 0;
+    return QUO_SUCCESS;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_auto_distrib_assign(QUO_t *q,
+                        QUO_obj_type_t distrib_over_this,
+                        int max_qids_per_res_type,
+                        int *out_selected,
+                        int *out_res_index,
+                        int flags)
+{
+    int rc = QUO_SUCCESS;
+
+    if (!q || !out_selected || !out_res_index || max_qids_per_res_type <= 0) {
+        return QUO_ERR_INVLD_ARG;
+    }
+    QUO_NO_INIT_ACTION(q);
+    *out_selected = 0; /* set default */
+    const bool min_migration = (flags & QUO_AUTO_DISTRIB_MIN_MIGRATION);
+    rc = auto_distrib(q, distrib_over_this, max_qids_per_res_type,
+                      min_migration, out_res_index);
+    if (QUO_SUCCESS != rc) return rc;
+    if (-1 == *out_res_index) return QUO_SUCCESS;
+    *out_selected = 1;
+    if (flags & QUO_AUTO_DISTRIB_BIND) {
+        rc = QUO_bind_push(q, QUO_BIND_PUSH_PROVIDED, distrib_over_this,
+                           *out_res_index);
+    }
+    return rc;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/** A qid and the cost it brings to whichever resource it is assigned. */
+typedef struct qid_cost_t {
+    double cost;
+    int qid;
+} qid_cost_t;
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/** Orders by decreasing cost, then by increasing qid so all agree. */
+static int
+cmp_qid_cost(const void *a,
+             const void *b)
+{
+    const qid_cost_t *qa = (const qid_cost_t *)a, *qb = (const qid_cost_t *)b;
+
+    if (qa->cost > qb->cost) return -1;
+    if (qa->cost < qb->cost) return 1;
+    return (qa->qid > qb->qid) - (qa->qid < qb->qid);
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Longest processing time first: the costliest unassigned qid goes to the
+ * least loaded resource that still has room. Load ties favor a resource the
+ * qid already covers (so it needn't move), then the lowest index.
+ */
+static int
+weighted_assign(int nqids,
+                int nres,
+                int max_qids_per_res_type,
+                const double *costs,
+                const int *nranks_in_res,
+                int **rank_ids_in_res,
+                int *out_assigned)
+{
+    int rc = QUO_SUCCESS;
+    qid_cost_t *order = calloc(nqids, sizeof(*order));
+    double *load = calloc(nres, sizeof(*load));
+    int *nassigned = calloc(nres, sizeof(*nassigned));
+    bool *covers = calloc((size_t)nres * nqids, sizeof(*covers));
+
+    if (!order || !load || !nassigned || !covers) {
+        QUO_OOR_COMPLAIN();
+        rc = QUO_ERR_OOR;
+        goto out;
+    }
+    for (int rid = 0; rid < nres; ++rid) {
+        for (int i = 0; i < nranks_in_res[rid]; ++i) {
+            covers[(size_t)rid * nqids + rank_ids_in_res[rid][i]] = true;
+        }
+    }
+    for (int qid = 0; qid < nqids; ++qid) {
+        order[qid].cost = costs[qid];
+        order[qid].qid = qid;
+        out_assigned[qid] = -1;
+    }
+    qsort(order, nqids, sizeof(*order), cmp_qid_cost);
+    for (int i = 0; i < nqids; ++i) {
+        const int qid = order[i].qid;
+        int best = -1;
         for (int rid = 0; rid < nres; ++rid) {
-            /* if already a member, stop search */
-            if (1 == *out_selected) break;
-            for (int rank = 0; rank < nranks_in_res[rid]; ++rank) {
-                /* if my current cpuset covers the resource in question and
-                 * someone won't be assigned to that particular resource */
-                if (my_smp_rank == rank_ids_in_res[rid][rank] &&
-                    rank < max_qids_per_res_type) {
-                    *out_selected = 1;
-                }
+            if (nassigned[rid] >= max_qids_per_res_type) continue;
+            if (-1 == best || load[rid] < load[best] ||
+                (load[rid] == load[best] &&
+                 covers[(size_t)rid * nqids + qid] &&
+                 !covers[(size_t)best * nqids + qid])) {
+                best = rid;
             }
         }
+        /* everything is full */
+        if (-1 == best) break;
+        out_assigned[qid] = best;
+        load[best] += order[i].cost;
+        nassigned[best]++;
     }
-    /* all processes overlap - really no hope of doing anything sane. we
-     * typically see this in the "no one is bound case." */
-    else if (nsmp_ranks == k_set_intersection_len) {
-        if (my_smp_rank < max_qids_per_res_type * nres) *out_selected = 1;
+out:
+    if (order) free(order);
+    if (load) free(load);
+    if (nassigned) free(nassigned);
+    if (covers) free(covers);
+    return rc;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Calculates the node-wide map of QUO_auto_distrib_weighted: out_map[qid] is
+ * the resource index assigned to qid, or -1.
+ */
+static int
+weighted_calc_map(QUO_t *q,
+                  QUO_obj_type_t distrib_over_this,
+                  int max_qids_per_res_type,
+                  const double *costs,
+                  int *out_map)
+{
+    int rc = QUO_SUCCESS, nres = 0;
+    int *nranks_in_res = NULL, **rank_ids_in_res = NULL;
+
+    if (QUO_SUCCESS != (rc = QUO_nobjs_by_type(q, distrib_over_this,
+                                               &nres))) {
+        return rc;
     }
-    /* only a few ranks share a resource. i don't know if this case will ever
-     * happen in practice, but i've seen stranger things... in any case, favor
-     * unshared resources. */
-    else {
-        /* construct a "hash table" large enough to accommodate all possible
-         * values up to nnoderanks - 1. note: these arrays are typically small,
-         * so who cares. if this ever changes, then update the code to use a
-         * proper hash table. */
-        int *big_htab = NULL, rmapped = 0;
-        size_t bhts = nsmp_ranks * sizeof(*big_htab);
-        if (NULL == (big_htab = malloc(bhts))) {
-            QUO_OOR_COMPLAIN();
-            rc = QUO_ERR_OOR;
+    if (0 == nres) return QUO_ERR_NOT_FOUND;
+    if (QUO_SUCCESS != (rc = get_qids_in_target_type(q, distrib_over_this, nres,
+                                                     &nranks_in_res,
+                                                     &rank_ids_in_res))) {
+        QUO_ERR_MSGRC("get_qids_in_target_type", rc);
+        return rc;
+    }
+    rc = weighted_assign(q->nqid, nres, max_qids_per_res_type, costs,
+                         nranks_in_res, rank_ids_in_res, out_map);
+    free(rank_ids_in_res[0]);
+    free(rank_ids_in_res);
+    free(nranks_in_res);
+    return rc;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_auto_distrib_weighted(QUO_t *q,
+                          QUO_obj_type_t distrib_over_this,
+                          int max_qids_per_res_type,
+                          double cost,
+                          int *out_selected,
+                          int *out_res_index,
+                          int flags)
+{
+    int rc = QUO_SUCCESS;
+    int *assigned = NULL;
+    double *costs = NULL;
+
+    if (!q || !out_selected || !out_res_index || max_qids_per_res_type <= 0) {
+        return QUO_ERR_INVLD_ARG;
+    }
+    QUO_NO_INIT_ACTION(q);
+    /* set defaults */
+    *out_selected = 0;
+    *out_res_index = -1;
+    costs = calloc(q->nqid, sizeof(*costs));
+    assigned = calloc(q->nqid, sizeof(*assigned));
+    if (!costs || !assigned) {
+        QUO_OOR_COMPLAIN();
+        rc = QUO_ERR_OOR;
+    }
+    /* no one can join the exchange unless everyone has somewhere to put it. */
+    if (QUO_SUCCESS != (rc = node_worst_rc(q, rc))) goto out;
+    /* everyone needs everyone's cost. */
+    if (QUO_SUCCESS != (rc = QUO_node_allgather(q, &cost, sizeof(cost),
+                                                costs))) {
+        QUO_ERR_MSGRC("QUO_node_allgather", rc);
+        goto out;
+    }
+    /* checked after the exchange, so a bad cost anywhere fails everyone. */
+    for (int qid = 0; qid < q->nqid; ++qid) {
+        if (!(costs[qid] >= 0.0)) {
+            rc = QUO_ERR_INVLD_ARG;
             goto out;
         }
-        /* -1 = spot not taken */
-        (void)memset(big_htab, -1, bhts);
-        /* populate the hash table */
-        for (int i = 0; i < k_set_intersection_len; ++i) {
-            big_htab[k_set_intersection[i]] = k_set_intersection[i];
+    }
+    /* qid 0 calculates the map and shares it. */
+    if (0 == q->qid) {
+        rc = weighted_calc_map(q, distrib_over_this, max_qids_per_res_type,
+                               costs, assigned);
+    }
+    if (QUO_SUCCESS != (rc = share_map(q, rc, assigned))) goto out;
+    if (QUO_SUCCESS != (rc = keep_map(q, assigned))) goto out;
+    *out_res_index = assigned[q->qid];
+    if (-1 == *out_res_index) goto out;
+    *out_selected = 1;
+    if (flags & QUO_AUTO_DISTRIB_BIND) {
+        rc = QUO_bind_push(q, QUO_BIND_PUSH_PROVIDED, distrib_over_this,
+                           *out_res_index);
+    }
+out:
+    if (assigned) free(assigned);
+    if (costs) free(costs);
+    return rc;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Distributes the qids that were given parent resource pid at the previous
+ * level (see assigned) over the resources of the given type inside of it. The
+ * results go into next_assigned: qids that don't make the cut get -1.
+ */
+static int
+hier_level_assign(QUO_t *q,
+                  QUO_obj_type_t parent_type,
+                  int pid,
+                  QUO_obj_type_t type,
+                  int max_qids_per_res_type,
+                  const int *assigned,
+                  int *qids,
+                  int *res,
+                  int *next_assigned)
+{
+    int rc = QUO_SUCCESS, first = -1, nres = 0, nqids = 0;
+
+    for (int qid = 0; qid < q->nqid; ++qid) {
+        if (pid == assigned[qid]) qids[nqids++] = qid;
+    }
+    if (0 == nqids) return QUO_SUCCESS;
+    rc = quo_hwloc_get_first_obj_in_type_by_type(q->hwloc, parent_type, pid,
+                                                 type, &first);
+    if (QUO_SUCCESS != rc) return rc;
+    rc = QUO_nobjs_in_type_by_type(q, parent_type, pid, type, &nres);
+    if (QUO_SUCCESS != rc) return rc;
+    if (-1 == first) nres = 0;
+    rc = min_migration_assign(q, type, nres * max_qids_per_res_type, nqids,
+                              qids, first, nres, res);
+    if (QUO_SUCCESS != rc) return rc;
+    for (int i = 0; i < nqids; ++i) next_assigned[qids[i]] = res[i];
+    return QUO_SUCCESS;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Makes sure every level's resources are each inside exactly one resource of
+ * the level above it.
+ */
+static int
+hier_levels_valid(QUO_t *q,
+                  const QUO_obj_type_t *levels,
+                  int nlevels)
+{
+    int rc = QUO_SUCCESS;
+
+    for (int l = 1; l < nlevels; ++l) {
+        int nparents = 0, nchildren = 0, ninside = 0;
+        if (levels[l] == levels[l - 1]) return QUO_ERR_INVLD_ARG;
+        rc = QUO_nobjs_by_type(q, levels[l - 1], &nparents);
+        if (QUO_SUCCESS != rc) return rc;
+        rc = QUO_nobjs_by_type(q, levels[l], &nchildren);
+        if (QUO_SUCCESS != rc) return rc;
+        for (int pid = 0; pid < nparents; ++pid) {
+            int n = 0;
+            rc = QUO_nobjs_in_type_by_type(q, levels[l - 1], pid, levels[l],
+                                           &n);
+            if (QUO_SUCCESS != rc) return rc;
+            ninside += n;
         }
-        /* first only consider ranks that aren't sharing resources */
-        for (int rid = 0; rid < nres; ++rid) {
-            /* if already a member, stop search */
-            if (1 == *out_selected) break;
-            rmapped = 0;
-            for (int rank = 0; rank < nranks_in_res[rid]; ++rank) {
-                /* this thing is shared - skip */
-                if (-1 != big_htab[rank_ids_in_res[rid][rank]]) continue;
-                /* if my current cpuset covers the resource in question */
-                if (my_smp_rank == rank_ids_in_res[rid][rank] &&
-                    rmapped < max_qids_per_res_type) {
-                        *out_selected = 1;
-                        break;
-                }
-                ++rmapped;
-            }
+        /* a child that straddles parents (or a "child" that is really a
+         * parent) would be counted more than once */
+        if (ninside != nchildren) return QUO_ERR_INVLD_ARG;
+    }
+    return QUO_SUCCESS;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Calculates the node-wide map of QUO_auto_distrib_hier: out_map[qid] is the
+ * leaf resource index assigned to qid, or -1.
+ */
+static int
+hier_calc_map(QUO_t *q,
+              const QUO_obj_type_t *levels,
+              const int *max_qids_per_res_type,
+              int nlevels,
+              int *out_map)
+{
+    int rc = QUO_SUCCESS, nres = 0;
+    int *assigned = out_map, *next = NULL, *qids = NULL, *res = NULL;
+
+    next = calloc(q->nqid, sizeof(*next));
+    qids = calloc(q->nqid, sizeof(*qids));
+    res = calloc(q->nqid, sizeof(*res));
+    if (!next || !qids || !res) {
+        QUO_OOR_COMPLAIN();
+        rc = QUO_ERR_OOR;
+        goto out;
+    }
+    /* the top level is distributed over all of its resources. */
+    if (QUO_SUCCESS != (rc = QUO_nobjs_by_type(q, levels[0], &nres))) goto out;
+    if (0 == nres) {
+        rc = QUO_ERR_NOT_FOUND;
+        goto out;
+    }
+    rc = min_migration_assign(q, levels[0], nres * max_qids_per_res_type[0],
+                              q->nqid, NULL, 0, nres, assigned);
+    if (QUO_SUCCESS != rc) goto out;
+    /* every level below that only within what the level above handed out. */
+    for (int l = 1; l < nlevels; ++l) {
+        int nparents = 0;
+        if (QUO_SUCCESS != (rc = QUO_nobjs_by_type(q, levels[l - 1],
+                                                   &nparents))) {
+            goto out;
         }
-        if (big_htab) free(big_htab);
+        for (int qid = 0; qid < q->nqid; ++qid) next[qid] = -1;
+        for (int pid = 0; pid < nparents; ++pid) {
+            rc = hier_level_assign(q, levels[l - 1], pid, levels[l],
+                                   max_qids_per_res_type[l], assigned, qids,
+                                   res, next);
+            if (QUO_SUCCESS != rc) goto out;
+        }
+        int *tmp = assigned;
+        assigned = next;
+        next = tmp;
+    }
+    if (assigned != out_map) {
+        memcpy(out_map, assigned, q->nqid * sizeof(*out_map));
+        /* the buffer we allocated is in assigned now */
+        next = assigned;
     }
 out:
-    /* the resources returned by get_qids_in_target_type must be freed by us */
-    if (rank_ids_in_res) {
-        for (int i = 0; i < nres; ++i) {
-            if (rank_ids_in_res[i]) free(rank_ids_in_res[i]);
+    if (next) free(next);
+    if (qids) free(qids);
+    if (res) free(res);
+    return rc;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_auto_distrib_hier(QUO_t *q,
+                      const QUO_obj_type_t *levels,
+                      const int *max_qids_per_res_type,
+                      int nlevels,
+                      int *out_selected,
+                      int *out_leaf_index,
+                      int flags)
+{
+    int rc = QUO_SUCCESS;
+    int *assigned = NULL;
+
+    if (!q || !levels || !max_qids_per_res_type || nlevels <= 0 ||
+        !out_selected || !out_leaf_index) {
+        return QUO_ERR_INVLD_ARG;
+    }
+    for (int l = 0; l < nlevels; ++l) {
+        if (max_qids_per_res_type[l] <= 0) return QUO_ERR_INVLD_ARG;
+    }
+    QUO_NO_INIT_ACTION(q);
+    /* set defaults */
+    *out_selected = 0;
+    *out_leaf_index = -1;
+    if (QUO_SUCCESS != (rc = hier_levels_valid(q, levels, nlevels))) {
+        return rc;
+    }
+    if (NULL == (assigned = calloc(q->nqid, sizeof(*assigned)))) {
+        QUO_OOR_COMPLAIN();
+        rc = QUO_ERR_OOR;
+    }
+    /* qid 0 calculates the map and shares it. */
+    if (QUO_SUCCESS == rc && 0 == q->qid) {
+        rc = hier_calc_map(q, levels, max_qids_per_res_type, nlevels,
+                           assigned);
+    }
+    if (QUO_SUCCESS != (rc = share_map(q, rc, assigned))) goto out;
+    if (QUO_SUCCESS != (rc = keep_map(q, assigned))) goto out;
+    *out_leaf_index = assigned[q->qid];
+    if (-1 == *out_leaf_index) goto out;
+    *out_selected = 1;
+    if (flags & QUO_AUTO_DISTRIB_BIND) {
+        rc = QUO_bind_push(q, QUO_BIND_PUSH_PROVIDED, levels[nlevels - 1],
+                           *out_leaf_index);
+    }
+out:
+    if (assigned) free(assigned);
+    return rc;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/** What a node brings to a global placement. */
+typedef struct node_res_t {
+    /** Number of resources of the target type. */
+    int nres;
+    /** Number of processes. */
+    int nqids;
+    /** Number of PUs. */
+    int npus;
+} node_res_t;
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Splits nactive active processes over the nodes: each one goes to the node
+ * with the most PUs per active process that still has an idle process (lowest
+ * index on ties). If nactive is less than 1, every node gets one per resource.
+ * Every leader calculates the same split.
+ */
+static void
+split_over_nodes(int nnodes,
+                 const node_res_t *nodes,
+                 int nactive,
+                 int *out_nactive)
+{
+    int total = 0;
+
+    for (int n = 0; n < nnodes; ++n) out_nactive[n] = 0;
+    if (nactive < 1) {
+        for (int n = 0; n < nnodes; ++n) {
+            out_nactive[n] = (nodes[n].nres < nodes[n].nqids) ?
+                             nodes[n].nres : nodes[n].nqids;
         }
-        free(rank_ids_in_res);
+        return;
     }
-    if (nranks_in_res) free(nranks_in_res);
-    if (k_set_intersection) free(k_set_intersection);
+    for (; total < nactive; ++total) {
+        int best = -1;
+        for (int n = 0; n < nnodes; ++n) {
+            if (out_nactive[n] >= nodes[n].nqids || 0 == nodes[n].nres) {
+                continue;
+            }
+            /* npus[n] / (a[n] + 1) > npus[best] / (a[best] + 1) */
+            if (-1 == best ||
+                (long long)nodes[n].npus * (out_nactive[best] + 1) >
+                (long long)nodes[best].npus * (out_nactive[n] + 1)) {
+                best = n;
+            }
+        }
+        /* every process is active */
+        if (-1 == best) break;
+        out_nactive[best]++;
+    }
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Run by node leaders: combines what every node has and returns the number of
+ * active processes on my node (out_counts[0]) and in the job (out_counts[1]).
+ */
+static int
+leaders_split(MPI_Comm leaders,
+              int nnodes,
+              const node_res_t *mine,
+              int nactive,
+              int *out_counts)
+{
+    int rc = QUO_SUCCESS, my_node = 0, oor = 0, any_oor = 0;
+    int *node_nactive = calloc(nnodes, sizeof(*node_nactive));
+    node_res_t *nodes = calloc(nnodes, sizeof(*nodes));
+
+    if (!nodes || !node_nactive) {
+        QUO_OOR_COMPLAIN();
+        oor = 1;
+    }
+    /* a leader that can't take part in the exchange takes everyone out. */
+    if (MPI_SUCCESS != MPI_Allreduce(&oor, &any_oor, 1, MPI_INT, MPI_MAX,
+                                     leaders)) {
+        rc = QUO_ERR_MPI;
+        goto out;
+    }
+    if (any_oor) {
+        rc = QUO_ERR_OOR;
+        goto out;
+    }
+    if (MPI_SUCCESS != MPI_Comm_rank(leaders, &my_node) ||
+        MPI_SUCCESS != MPI_Allgather(mine, sizeof(*mine), MPI_BYTE,
+                                     nodes, sizeof(*mine), MPI_BYTE,
+                                     leaders)) {
+        rc = QUO_ERR_MPI;
+        goto out;
+    }
+    split_over_nodes(nnodes, nodes, nactive, node_nactive);
+    out_counts[0] = node_nactive[my_node];
+    out_counts[1] = 0;
+    for (int n = 0; n < nnodes; ++n) out_counts[1] += node_nactive[n];
+out:
+    if (nodes) free(nodes);
+    if (node_nactive) free(node_nactive);
+    return rc;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_global_place(QUO_t *q,
+                 QUO_obj_type_t res_type,
+                 int nactive,
+                 int flags,
+                 QUO_placement_t *out_placement)
+{
+    int rc = QUO_SUCCESS, nnodes = 0, npus_in_res = 0;
+    /* [0]: number active on my node (minus the leader's error code if it
+     * failed), [1]: number active in the job */
+    int counts[2] = {0, 0};
+    int *assigned = NULL;
+    node_res_t mine;
+    MPI_Comm leaders = MPI_COMM_NULL;
+
+    if (!q || !out_placement) return QUO_ERR_INVLD_ARG;
+    QUO_NO_INIT_ACTION(q);
+    (void)memset(out_placement, 0, sizeof(*out_placement));
+    out_placement->res_index = -1;
 
+    mine.nqids = q->nqid;
+    if (QUO_SUCCESS != (rc = QUO_nobjs_by_type(q, res_type, &mine.nres))) {
+        return rc;
+    }
+    if (QUO_SUCCESS != (rc = QUO_npus(q, &mine.npus))) return rc;
+    if (QUO_SUCCESS != (rc = QUO_nnodes(q, &nnodes))) return rc;
+    /* leaders combine what every node has and decide on the split. */
+    if (QUO_SUCCESS != (rc = QUO_get_leader_comm(q, QUO_OBJ_MACHINE,
+                                                 &leaders))) {
+        return rc;
+    }
+    if (MPI_COMM_NULL != leaders) {
+        rc = leaders_split(leaders, nnodes, &mine, nactive, counts);
+        /* tell the rest of the node instead of leaving it waiting */
+        if (QUO_SUCCESS != rc) counts[0] = -rc;
+    }
+    if (QUO_SUCCESS != (rc = QUO_node_bcast(q, counts, sizeof(counts), 0))) {
+        return rc;
+    }
+    if (counts[0] < 0) return -counts[0];
+    out_placement->nactive_on_node = counts[0];
+    out_placement->nactive = counts[1];
+    /* qid 0 picks the active processes on my node and shares its pick. */
+    if (NULL == (assigned = calloc(q->nqid, sizeof(*assigned)))) {
+        QUO_OOR_COMPLAIN();
+        rc = QUO_ERR_OOR;
+    }
+    if (QUO_SUCCESS == rc && 0 == q->qid) {
+        if (0 == counts[0]) {
+            for (int qid = 0; qid < q->nqid; ++qid) assigned[qid] = -1;
+        }
+        else {
+            rc = min_migration_assign(q, res_type, counts[0], q->nqid, NULL, 0,
+                                      mine.nres, assigned);
+        }
+    }
+    if (QUO_SUCCESS != (rc = share_map(q, rc, assigned))) goto out;
+    if (QUO_SUCCESS != (rc = keep_map(q, assigned))) goto out;
+    const int my_res = assigned[q->qid];
+    if (-1 == my_res) goto out;
+    /* threads fill my resource together with whoever else got it. */
+    int nsharing = 0;
+    for (int qid = 0; qid < q->nqid; ++qid) {
+        if (my_res == assigned[qid]) ++nsharing;
+    }
+    rc = QUO_nobjs_in_type_by_type(q, res_type, my_res, QUO_OBJ_PU,
+                                   &npus_in_res);
+    if (QUO_SUCCESS != rc) goto out;
+    out_placement->active = 1;
+    out_placement->res_index = my_res;
+    out_placement->nthreads = (npus_in_res / nsharing > 0) ?
+                              npus_in_res / nsharing : 1;
+    if (flags & QUO_AUTO_DISTRIB_BIND) {
+        rc = QUO_bind_push(q, QUO_BIND_PUSH_PROVIDED, res_type, my_res);
+    }
+out:
+    if (assigned) free(assigned);
     return rc;
 }
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_auto_distrib_get_map(QUO_t *q,
+                         int *out_map)
+{
+    if (!q || !out_map) return QUO_ERR_INVLD_ARG;
+    QUO_NO_INIT_ACTION(q);
+    if (!q->ad_map) return QUO_ERR_NOT_FOUND;
+    (void)memcpy(out_map, q->ad_map, q->nqid * sizeof(*out_map));
+    return QUO_SUCCESS;
+}
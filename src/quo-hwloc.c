@@ -54,6 +54,7 @@
 #include "quo-private.h"
 #include "quo-sm.h"
 #include "quo-mpi.h"
+#include "quo-utils.h"
 
 #ifdef HAVE_STDLIB_H
 #include <stdlib.h>
@@ -73,18 +74,71 @@
 #ifdef HAVE_SYSCALL_H
 #include <syscall.h>
 #endif
+#ifdef HAVE_STDINT_H
+#include <stdint.h>
+#endif
+#ifdef HAVE_SCHED_H
+#include <sched.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+/** Initial number of bitmaps in the bind stack pool. Doubled as needed. */
+#define BIND_STACK_INIT_SIZE 8
 
-/** Constant that dictates the max size of the bind stack - should be plenty. */
-#define BIND_STACK_SIZE 128
+/**
+ * When set, binding queries ask the OS instead of trusting the bind stack.
+ * For applications that change their affinity behind libquo's back.
+ */
+#define QUO_BIND_REVALIDATE_ENV_VAR_STR "QUO_BIND_REVALIDATE"
 
-/** The almighty bind stack. */
+/**
+ * The almighty bind stack (of cpusets or, for memory binding, nodesets).
+ * Backed by a pool of preallocated bitmaps: slots at and above top keep their
+ * bitmaps around for reuse, so push and pop do not allocate once the pool is
+ * large enough.
+ */
 typedef struct bind_stack_t {
     /** Index to top of the stack. */
     int top;
-    /** Array-based bind stack container. */
-    quo_internal_hwloc_cpuset_t bind_stack[BIND_STACK_SIZE];
+    /** Number of bitmaps in the pool. */
+    int size;
+    /** Pool-backed bind stack container. */
+    quo_internal_hwloc_bitmap_t *bind_stack;
+    /** Flags the entries were pushed with. */
+    int *flags;
 } bind_stack_t;
 
+/** A buffer registered for page migration. */
+typedef struct membuf_t {
+    /** Base address. */
+    const void *addr;
+    /** Length (in B). */
+    size_t len;
+} membuf_t;
+
+/** Assumed cache line size (in B). Affinity table entries are padded to it. */
+#define AFF_CACHE_LINE_SIZE 64
+
+/** Number of cpuset words that the binding queries keep on the stack (1024
+ * PUs with 64-bit words). Bigger machines use the heap instead. */
+#define AFF_STACK_NWORDS 16
+
+/**
+ * Entry of the node-wide affinity table: a shared-memory table in which every
+ * node-local process publishes its current cpuset whenever its binding
+ * changes. There is one entry per node-local process, protected by a sequence
+ * lock: the owner makes seq odd, updates the cpuset words, and makes seq even
+ * again. Readers retry if seq was odd or changed while they were reading.
+ */
+typedef struct aff_entry_t {
+    /** Sequence lock. */
+    uint64_t seq;
+    /** The published cpuset, as hwloc ulongs. */
+    unsigned long words[];
+} aff_entry_t;
+
 /** Structure that holds hwloc-related state. */
 struct quo_hwloc_t {
     /** The system's topology. */
@@ -93,12 +147,60 @@ struct quo_hwloc_t {
     quo_internal_hwloc_cpuset_t widest_cpuset;
     /** The bind stack. */
     bind_stack_t bstack;
+    /** The memory bind stack. Its bottom entry is the memory binding that was
+     * in effect before the first push. */
+    bind_stack_t mbstack;
+    /** Memory binding policy of the bottom entry of the memory bind stack. */
+    quo_internal_hwloc_membind_policy_t membind_base_policy;
+    /** Buffers moved by migrating memory binding changes. If there are none,
+     * the whole process is migrated. */
+    membuf_t *membufs;
+    /** Number of registered buffers. */
+    int nmembufs;
+    /** Capacity of membufs. */
+    int membufs_size;
+    /** Bytes moved by the last migrating memory binding change. */
+    size_t migrate_nbytes;
+    /** Time (in s) taken by the last migrating memory binding change. */
+    double migrate_secs;
     /** Cached PID. */
     pid_t mypid;
     /** Cached node ID. */
     int nid;
     /** Used to store hardware topology information. */
     quo_sm_t *htopo_sm;
+    /** hwloc depth of each type (negative if there is no such level). */
+    int obj_depth[QUO_OBJ_NTYPES];
+    /** Number of objects of each type. */
+    int nobjs[QUO_OBJ_NTYPES];
+    /** Offset of each type's first object in obj_table. */
+    int obj_offs[QUO_OBJ_NTYPES];
+    /** All objects of interest, grouped by type, in logical index order. */
+    quo_internal_hwloc_obj_t *obj_table;
+    /** For every object in obj_table, the number of objects of each type
+     * inside of it: nobjs_in[(obj_offs[in_type] + i) * QUO_OBJ_NTYPES + type]. */
+    int *nobjs_in;
+    /** Binding epoch. Bumped every time our binding changes. */
+    unsigned long bind_epoch;
+    /** Whether or not binding queries must always ask the OS. */
+    bool revalidate_bind;
+    /** How process and thread bindings treat SMT siblings. */
+    QUO_smt_policy_t smt_policy;
+    /** Whether or not threads were bound (e.g. by quo_hwloc_bind_thread) since
+     * the last process binding change. The bind stack doesn't know about
+     * thread bindings, so the next change must not be skipped as a no-op. Set
+     * from many threads at once, hence the atomic accesses. */
+    bool thread_bound;
+    /** Number of node-local processes. */
+    int nnoderanks;
+    /** Shared memory backing the node-wide affinity table. */
+    quo_sm_t *aff_sm;
+    /** Base of the affinity table entries. */
+    char *aff_entries;
+    /** Distance (in B) between affinity table entries. */
+    size_t aff_stride;
+    /** Number of cpuset words in an affinity table entry. */
+    unsigned aff_nwords;
 };
 
 /* ////////////////////////////////////////////////////////////////////////// */
@@ -117,35 +219,69 @@ valid_bind_policy(QUO_bind_push_policy_t policy)
 
 /* ////////////////////////////////////////////////////////////////////////// */
 /**
- * Takes a QUO object type and converts it to hwloc's equivalent.
+ * Returns the depth of the innermost level of hwloc groups, or
+ * HWLOC_TYPE_DEPTH_UNKNOWN if there are none.
+ */
+static int
+group_depth(quo_internal_hwloc_topology_t topo)
+{
+    for (int d = (int)quo_internal_hwloc_topology_get_depth(topo) - 1;
+         d >= 0; --d) {
+        if (HWLOC_OBJ_GROUP == quo_internal_hwloc_get_depth_type(topo, d)) {
+            return d;
+        }
+    }
+    return HWLOC_TYPE_DEPTH_UNKNOWN;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Takes a QUO object type and converts it to the depth of hwloc's equivalent.
+ * *out_depth is negative (HWLOC_TYPE_DEPTH_UNKNOWN or
+ * HWLOC_TYPE_DEPTH_MULTIPLE) if the topology has no (single) such level.
  */
 static int
-ext2intobj(QUO_obj_type_t external,
-           quo_internal_hwloc_obj_type_t *internal)
+ext2intdepth(quo_internal_hwloc_topology_t topo,
+             QUO_obj_type_t external,
+             int *out_depth)
 {
-    if (!internal) return QUO_ERR_INVLD_ARG;
+    if (!out_depth) return QUO_ERR_INVLD_ARG;
     /* convert from ours to hwloc's. if you ever need more types, add them here
      * and in quo.h. */
     switch (external) {
         case QUO_OBJ_MACHINE:
-            *internal = HWLOC_OBJ_MACHINE;
+            *out_depth = quo_internal_hwloc_get_type_depth(topo,
+                                                           HWLOC_OBJ_MACHINE);
             break;
         case QUO_OBJ_NUMANODE:
-            *internal = HWLOC_OBJ_NUMANODE;
+            *out_depth = quo_internal_hwloc_get_type_depth(topo,
+                                                           HWLOC_OBJ_NUMANODE);
             break;
         case QUO_OBJ_SOCKET:
-            *internal = HWLOC_OBJ_SOCKET;
+            *out_depth = quo_internal_hwloc_get_type_depth(topo,
+                                                           HWLOC_OBJ_SOCKET);
             break;
         case QUO_OBJ_CORE:
-            *internal = HWLOC_OBJ_CORE;
+            *out_depth = quo_internal_hwloc_get_type_depth(topo,
+                                                           HWLOC_OBJ_CORE);
             break;
         case QUO_OBJ_PU:
-            *internal = HWLOC_OBJ_PU;
+            *out_depth = quo_internal_hwloc_get_type_depth(topo, HWLOC_OBJ_PU);
+            break;
+        /* data (or unified) caches of the given level */
+        case QUO_OBJ_L1CACHE:
+        case QUO_OBJ_L2CACHE:
+        case QUO_OBJ_L3CACHE:
+            *out_depth = quo_internal_hwloc_get_cache_type_depth(
+                             topo, 1 + (external - QUO_OBJ_L1CACHE),
+                             HWLOC_OBJ_CACHE_DATA
+                         );
+            break;
+        case QUO_OBJ_GROUP:
+            *out_depth = group_depth(topo);
             break;
         default:
-            /* well, we'll just return the machine if something weird was passed
-             * to us. check your return codes, folks! */
-            *internal = HWLOC_OBJ_MACHINE;
+            *out_depth = HWLOC_TYPE_DEPTH_UNKNOWN;
             return QUO_ERR_INVLD_ARG;
     }
     return QUO_SUCCESS;
@@ -191,6 +327,47 @@ out:
     return rc;
 }
 
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Provides the current binding of the given process. Our own binding is read
+ * straight from the top of the bind stack (no system call, no allocation)
+ * unless revalidation was requested. Otherwise, the OS is asked and
+ * *out_tofree is set to a bitmap the caller must free. Looks at the bind
+ * stack, so only for use on the (single-threaded) binding paths; queries use
+ * read_cur_bind.
+ */
+static int
+get_cur_bind_ref(const quo_hwloc_t *hwloc,
+                 pid_t who_pid,
+                 quo_internal_hwloc_const_cpuset_t *out_cpuset,
+                 quo_internal_hwloc_cpuset_t *out_tofree)
+{
+    int rc = QUO_SUCCESS;
+    quo_internal_hwloc_cpuset_t cur_bind = NULL;
+
+    if (!hwloc || !out_cpuset || !out_tofree) return QUO_ERR_INVLD_ARG;
+    *out_tofree = NULL;
+
+    if (who_pid == hwloc->mypid && !hwloc->revalidate_bind &&
+        hwloc->bstack.top > 0) {
+        *out_cpuset = hwloc->bstack.bind_stack[hwloc->bstack.top - 1];
+        return QUO_SUCCESS;
+    }
+    if (QUO_SUCCESS != (rc = get_cur_bind(hwloc, who_pid, &cur_bind))) {
+        return rc;
+    }
+    *out_cpuset = cur_bind;
+    *out_tofree = cur_bind;
+    return QUO_SUCCESS;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+static inline bool
+valid_obj_type(QUO_obj_type_t type)
+{
+    return type >= QUO_OBJ_MACHINE && type < QUO_OBJ_NTYPES;
+}
+
 /* ////////////////////////////////////////////////////////////////////////// */
 static int
 get_obj_by_type(const quo_hwloc_t *hwloc,
@@ -198,20 +375,12 @@ get_obj_by_type(const quo_hwloc_t *hwloc,
                 unsigned type_index,
                 quo_internal_hwloc_obj_t *out_obj)
 {
-    int rc = QUO_ERR;
-    quo_internal_hwloc_obj_type_t real_type = HWLOC_OBJ_MACHINE;
-
     if (!hwloc || !out_obj) return QUO_ERR_INVLD_ARG;
     *out_obj = NULL;
-    if (QUO_SUCCESS != (rc = ext2intobj(type, &real_type))) return rc;
-    if (NULL == (*out_obj = quo_internal_hwloc_get_obj_by_type(hwloc->topo,
-                                                               real_type,
-                                                               type_index))) {
-        /* there are a couple of reasons why target_obj may be NULL. if this
-         * ever happens and the specified type and obj index should be valid,
-         * then read the hwloc documentation and make this code mo betta. */
-        return QUO_ERR_INVLD_ARG;
-    }
+    if (!valid_obj_type(type)) return QUO_ERR_INVLD_ARG;
+    /* no such object */
+    if (type_index >= (unsigned)hwloc->nobjs[type]) return QUO_ERR_INVLD_ARG;
+    *out_obj = hwloc->obj_table[hwloc->obj_offs[type] + type_index];
     return QUO_SUCCESS;
 }
 
@@ -222,109 +391,275 @@ get_obj_covering_cur_bind(const quo_hwloc_t *hwloc,
                           quo_internal_hwloc_obj_t *out_obj)
 {
     int rc = QUO_ERR;
-    quo_internal_hwloc_cpuset_t curbind = NULL;
-    quo_internal_hwloc_obj_type_t real_type = HWLOC_OBJ_MACHINE;
+    quo_internal_hwloc_const_cpuset_t curbind = NULL;
+    quo_internal_hwloc_cpuset_t tofree = NULL;
 
     if (!hwloc || !out_obj) return QUO_ERR_INVLD_ARG;
-    if (QUO_SUCCESS != (rc = ext2intobj(type, &real_type))) return rc;
-    if (QUO_SUCCESS != (rc = get_cur_bind(hwloc, hwloc->mypid, &curbind))) {
+    if (!valid_obj_type(type)) return QUO_ERR_INVLD_ARG;
+    if (hwloc->obj_depth[type] < 0) return QUO_ERR_NOT_FOUND;
+    if (QUO_SUCCESS != (rc = get_cur_bind_ref(hwloc, hwloc->mypid,
+                                              &curbind, &tofree))) {
         return rc;
     }
-    *out_obj = quo_internal_hwloc_get_next_obj_covering_cpuset_by_type(
+    *out_obj = quo_internal_hwloc_get_next_obj_covering_cpuset_by_depth(
                    hwloc->topo, curbind,
-                   real_type, NULL
+                   hwloc->obj_depth[type], NULL
                );
     if (!*out_obj) {
         rc = QUO_ERR_NOT_FOUND;
         goto out;
     }
 out:
-    if (curbind) quo_internal_hwloc_bitmap_free(curbind);
+    if (tofree) quo_internal_hwloc_bitmap_free(tofree);
     return rc;
 }
 
 /* ////////////////////////////////////////////////////////////////////////// */
-static bool
-bind_stack_full(const quo_hwloc_t *hwloc)
+/**
+ * Makes sure that there is a preallocated bitmap for the next push, growing
+ * the pool if need be.
+ */
+static int
+bind_stack_reserve(bind_stack_t *bs)
+{
+    quo_internal_hwloc_bitmap_t *tmp = NULL;
+    int *tmpf = NULL;
+
+    if (bs->top < bs->size) return QUO_SUCCESS;
+
+    const int new_size = bs->size ? 2 * bs->size : BIND_STACK_INIT_SIZE;
+    if (NULL == (tmpf = realloc(bs->flags, new_size * sizeof(*tmpf)))) {
+        QUO_OOR_COMPLAIN();
+        return QUO_ERR_OOR;
+    }
+    bs->flags = tmpf;
+    if (NULL == (tmp = realloc(bs->bind_stack, new_size * sizeof(*tmp)))) {
+        QUO_OOR_COMPLAIN();
+        return QUO_ERR_OOR;
+    }
+    bs->bind_stack = tmp;
+    for (; bs->size < new_size; ++bs->size) {
+        if (NULL == (tmp[bs->size] = quo_internal_hwloc_bitmap_alloc())) {
+            /* keep what we got, the next reserve will try again */
+            if (bs->top < bs->size) return QUO_SUCCESS;
+            QUO_OOR_COMPLAIN();
+            return QUO_ERR_OOR;
+        }
+    }
+    return QUO_SUCCESS;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+static void
+bind_stack_free(bind_stack_t *bs)
 {
-    return hwloc->bstack.top >= BIND_STACK_SIZE;
+    for (int i = 0; i < bs->size; ++i) {
+        quo_internal_hwloc_bitmap_free(bs->bind_stack[i]);
+    }
+    if (bs->bind_stack) free(bs->bind_stack);
+    if (bs->flags) free(bs->flags);
+    bs->bind_stack = NULL;
+    bs->flags = NULL;
+    bs->top = bs->size = 0;
 }
 
 /* ////////////////////////////////////////////////////////////////////////// */
 static int
-bind_stack_push(quo_hwloc_t *hwloc,
-                quo_internal_hwloc_cpuset_t cpuset)
+bind_stack_push(bind_stack_t *bs,
+                quo_internal_hwloc_const_bitmap_t set,
+                int flags)
 {
-    unsigned top = hwloc->bstack.top;
+    int rc = QUO_SUCCESS;
 
-    if (!hwloc) return QUO_ERR_INVLD_ARG;
-    /* stack is full - we are out of resources */
-    if (bind_stack_full(hwloc)) return QUO_ERR_OOR;
-    /* pop will cleanup after this call */
-    if (NULL == (hwloc->bstack.bind_stack[top] =
-                 quo_internal_hwloc_bitmap_alloc())) {
-        QUO_OOR_COMPLAIN();
-        return QUO_ERR_OOR;
-    }
+    if (!bs) return QUO_ERR_INVLD_ARG;
+    /* grow the pool if it is exhausted */
+    if (QUO_SUCCESS != (rc = bind_stack_reserve(bs))) return rc;
     /* copy the thing */
-    quo_internal_hwloc_bitmap_copy(hwloc->bstack.bind_stack[top], cpuset);
+    quo_internal_hwloc_bitmap_copy(bs->bind_stack[bs->top], set);
+    bs->flags[bs->top] = flags;
     /* update top */
-    hwloc->bstack.top++;
+    bs->top++;
     return QUO_SUCCESS;
 }
 
 /* ////////////////////////////////////////////////////////////////////////// */
 static int
-bind_stack_pop(quo_hwloc_t *hwloc,
-               quo_internal_hwloc_cpuset_t *popped)
+bind_stack_pop(bind_stack_t *bs,
+               quo_internal_hwloc_bitmap_t *popped)
 {
-    if (!hwloc) return QUO_ERR_INVLD_ARG;
+    if (!bs) return QUO_ERR_INVLD_ARG;
     /* stack is empty -- nothing to do */
-    if (hwloc->bstack.top <= 0) return QUO_ERR_POP;
-    /* remember top is the next empty slot, so decrement first */
-    hwloc->bstack.top--;
+    if (bs->top <= 0) return QUO_ERR_POP;
     /* if the caller wants a copy, give it to them */
     if (popped) {
-        if (NULL == (*popped = quo_internal_hwloc_bitmap_alloc())) {
+        if (NULL == (*popped = quo_internal_hwloc_bitmap_dup(
+                         bs->bind_stack[bs->top - 1]
+                     ))) {
             QUO_OOR_COMPLAIN();
-            /* restore top's val in error path */
-            hwloc->bstack.top++;
             return QUO_ERR_OOR;
         }
-        quo_internal_hwloc_bitmap_copy(
-            *popped,
-            hwloc->bstack.bind_stack[hwloc->bstack.top]
-        );
     }
-    /* free the top */
-    quo_internal_hwloc_bitmap_free(hwloc->bstack.bind_stack[hwloc->bstack.top]);
+    /* remember top is the next empty slot. the popped bitmap stays in the pool
+     * (and keeps its contents until the next push). */
+    bs->top--;
     return QUO_SUCCESS;
 }
 
 /* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Provides the entry at the top of the stack. The returned bitmap is owned by
+ * the stack and is only valid until the next push.
+ */
 static int
-bind_stack_top(quo_hwloc_t *hwloc,
-               quo_internal_hwloc_cpuset_t *top_copy)
+bind_stack_top(const bind_stack_t *bs,
+               quo_internal_hwloc_const_bitmap_t *top)
 {
-    if (!hwloc || !top_copy) return QUO_ERR_INVLD_ARG;
+    if (!bs || !top) return QUO_ERR_INVLD_ARG;
     /* stack is empty -- nothing to do */
-    if (hwloc->bstack.top <= 0) return QUO_ERR_POP;
-    if (NULL == (*top_copy = quo_internal_hwloc_bitmap_alloc())) {
-        QUO_OOR_COMPLAIN();
-        return QUO_ERR_OOR;
+    if (bs->top <= 0) return QUO_ERR_POP;
+    /* remember top is the next empty slot */
+    *top = bs->bind_stack[bs->top - 1];
+    return QUO_SUCCESS;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+static inline aff_entry_t *
+aff_entry(const quo_hwloc_t *hwloc,
+          int qid)
+{
+    return (aff_entry_t *)(hwloc->aff_entries + (qid * hwloc->aff_stride));
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Publishes the provided cpuset as my current binding in the node-wide
+ * affinity table.
+ */
+static void
+aff_publish(quo_hwloc_t *hwloc,
+            quo_internal_hwloc_const_cpuset_t cpuset)
+{
+    /* table not setup yet */
+    if (!hwloc->aff_entries) return;
+
+    aff_entry_t *e = aff_entry(hwloc, hwloc->nid);
+    /* i am the only writer of my entry */
+    const uint64_t seq = QUO_ATOMIC_LOAD_RLX(&e->seq);
+    QUO_ATOMIC_STORE_RLX(&e->seq, seq + 1);
+    QUO_ATOMIC_FENCE_REL();
+    for (unsigned i = 0; i < hwloc->aff_nwords; ++i) {
+        QUO_ATOMIC_STORE_RLX(&e->words[i],
+                             quo_internal_hwloc_bitmap_to_ith_ulong(cpuset, i));
+    }
+    QUO_ATOMIC_STORE_REL(&e->seq, seq + 2);
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Returns whether or not the published binding of the given qid intersects
+ * the provided cpuset. No system calls, no allocations.
+ */
+static bool
+aff_intersects(const quo_hwloc_t *hwloc,
+               int qid,
+               quo_internal_hwloc_const_cpuset_t cpuset)
+{
+    const aff_entry_t *e = aff_entry(hwloc, qid);
+    unsigned long hits = 0;
+    uint64_t seq = 0;
+
+    do {
+        while (1 & (seq = QUO_ATOMIC_LOAD_ACQ(&e->seq))) sched_yield();
+        hits = 0;
+        for (unsigned i = 0; i < hwloc->aff_nwords; ++i) {
+            hits |= QUO_ATOMIC_LOAD_RLX(&e->words[i]) &
+                    quo_internal_hwloc_bitmap_to_ith_ulong(cpuset, i);
+        }
+        QUO_ATOMIC_FENCE_ACQ();
+    } while (seq != QUO_ATOMIC_LOAD_RLX(&e->seq));
+
+    return 0 != hits;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Copies a consistent snapshot of the published binding of the given qid into
+ * words (aff_nwords long).
+ */
+static void
+aff_read(const quo_hwloc_t *hwloc,
+         int qid,
+         unsigned long *words)
+{
+    const aff_entry_t *e = aff_entry(hwloc, qid);
+    uint64_t seq = 0;
+
+    do {
+        while (1 & (seq = QUO_ATOMIC_LOAD_ACQ(&e->seq))) sched_yield();
+        for (unsigned i = 0; i < hwloc->aff_nwords; ++i) {
+            words[i] = QUO_ATOMIC_LOAD_RLX(&e->words[i]);
+        }
+        QUO_ATOMIC_FENCE_ACQ();
+    } while (seq != QUO_ATOMIC_LOAD_RLX(&e->seq));
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Read-side flavor of get_cur_bind_ref: copies the current binding of the
+ * given process into words (aff_nwords long). Our own binding comes from what
+ * we last published, so this never looks at the bind stack and is safe to
+ * call while another thread pushes or pops.
+ */
+static int
+read_cur_bind(const quo_hwloc_t *hwloc,
+              pid_t who_pid,
+              unsigned long *words)
+{
+    int rc = QUO_SUCCESS;
+    quo_internal_hwloc_cpuset_t cur_bind = NULL;
+
+    if (who_pid == hwloc->mypid && !hwloc->revalidate_bind) {
+        aff_read(hwloc, hwloc->nid, words);
+        return QUO_SUCCESS;
     }
-    /* remember top is the next empty slot, so decrement first */
-    hwloc->bstack.top--;
-    /* copy */
-    quo_internal_hwloc_bitmap_copy(
-        *top_copy,
-        hwloc->bstack.bind_stack[hwloc->bstack.top]
-    );
-    /* restore top */
-    hwloc->bstack.top++;
+    if (QUO_SUCCESS != (rc = get_cur_bind(hwloc, who_pid, &cur_bind))) {
+        return rc;
+    }
+    for (unsigned i = 0; i < hwloc->aff_nwords; ++i) {
+        words[i] = quo_internal_hwloc_bitmap_to_ith_ulong(cur_bind, i);
+    }
+    quo_internal_hwloc_bitmap_free(cur_bind);
     return QUO_SUCCESS;
 }
 
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Returns a buffer that can hold aff_nwords cpuset words: stack_words if they
+ * fit in it (the usual case, so the queries don't allocate), a new one from
+ * the heap otherwise. Returns NULL if we are out of memory. Release the buffer
+ * with aff_words_put.
+ */
+static unsigned long *
+aff_words_get(const quo_hwloc_t *hwloc,
+              unsigned long *stack_words)
+{
+    unsigned long *words = stack_words;
+
+    if (hwloc->aff_nwords > AFF_STACK_NWORDS) {
+        words = calloc(hwloc->aff_nwords, sizeof(*words));
+        if (!words) QUO_OOR_COMPLAIN();
+    }
+    return words;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+static void
+aff_words_put(unsigned long *words,
+              unsigned long *stack_words)
+{
+    if (words != stack_words) free(words);
+}
+
 /* ////////////////////////////////////////////////////////////////////////// */
 /**
  * push current binding.
@@ -340,7 +675,11 @@ push_cur_bind(quo_hwloc_t *hwloc)
     if (QUO_SUCCESS != (rc = get_cur_bind(hwloc, hwloc->mypid, &cur_bind))) {
         return rc;
     }
-    if (QUO_SUCCESS != (rc = bind_stack_push(hwloc, cur_bind))) goto out;
+    if (QUO_SUCCESS != (rc = bind_stack_push(&hwloc->bstack, cur_bind, 0))) {
+        goto out;
+    }
+    /* let everyone on the node know */
+    aff_publish(hwloc, cur_bind);
 out:
     /* push copies, so free the one we created */
     if (cur_bind) quo_internal_hwloc_bitmap_free(cur_bind);
@@ -355,6 +694,10 @@ init_cached_attrs(quo_hwloc_t *qh)
 
     /* stash our pid */
     qh->mypid = getpid();
+    /* should binding queries bypass the bind stack? */
+    int qrc = quo_utils_envvar_set(QUO_BIND_REVALIDATE_ENV_VAR_STR,
+                                   &qh->revalidate_bind);
+    if (QUO_SUCCESS != qrc) return qrc;
     if (NULL == (qh->widest_cpuset = quo_internal_hwloc_bitmap_alloc())) {
         QUO_OOR_COMPLAIN();
         return QUO_ERR_OOR;
@@ -385,12 +728,75 @@ quo_hwloc_construct(quo_hwloc_t **nhwloc)
         QUO_ERR_MSGRC("quo_sm_construct", qrc);
         goto out;
     }
+    if (QUO_SUCCESS != (qrc = quo_sm_construct(&(hwloc->aff_sm)))) {
+        QUO_ERR_MSGRC("quo_sm_construct", qrc);
+        goto out;
+    }
     *nhwloc = hwloc;
 out:
     if (QUO_SUCCESS != qrc) quo_hwloc_destruct(hwloc);
     return qrc;
 }
 
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * The topology never changes once loaded, so answer all of the object
+ * questions we will ever be asked up front: object lookups and (container,
+ * index, type) counts become table lookups.
+ */
+static int
+obj_tables_build(quo_hwloc_t *hwloc)
+{
+    int ntotal = 0;
+
+    for (int t = 0; t < QUO_OBJ_NTYPES; ++t) {
+        int depth = HWLOC_TYPE_DEPTH_UNKNOWN;
+        (void)ext2intdepth(hwloc->topo, (QUO_obj_type_t)t, &depth);
+        hwloc->obj_depth[t] = depth;
+        /* hwloc can't determine the number of x, so there are none */
+        if (HWLOC_TYPE_DEPTH_UNKNOWN == depth ||
+            HWLOC_TYPE_DEPTH_MULTIPLE == depth) {
+            hwloc->obj_depth[t] = HWLOC_TYPE_DEPTH_UNKNOWN;
+            hwloc->nobjs[t] = 0;
+        }
+        else {
+            hwloc->nobjs[t] =
+                quo_internal_hwloc_get_nbobjs_by_depth(hwloc->topo, depth);
+        }
+        hwloc->obj_offs[t] = ntotal;
+        ntotal += hwloc->nobjs[t];
+    }
+    hwloc->obj_table = calloc(ntotal, sizeof(*hwloc->obj_table));
+    hwloc->nobjs_in = calloc(ntotal * QUO_OBJ_NTYPES, sizeof(int));
+    if (!hwloc->obj_table || !hwloc->nobjs_in) {
+        QUO_OOR_COMPLAIN();
+        return QUO_ERR_OOR;
+    }
+    for (int t = 0; t < QUO_OBJ_NTYPES; ++t) {
+        for (int i = 0; i < hwloc->nobjs[t]; ++i) {
+            hwloc->obj_table[hwloc->obj_offs[t] + i] =
+                quo_internal_hwloc_get_obj_by_depth(hwloc->topo,
+                                                    hwloc->obj_depth[t], i);
+        }
+    }
+    for (int i = 0; i < ntotal; ++i) {
+        quo_internal_hwloc_obj_t in_obj = hwloc->obj_table[i];
+        for (int t = 0; t < QUO_OBJ_NTYPES; ++t) {
+            int nobjs = 0;
+            quo_internal_hwloc_obj_t obj = NULL;
+            if (hwloc->obj_depth[t] < 0) continue;
+            while ((obj =
+                    quo_internal_hwloc_get_next_obj_inside_cpuset_by_depth(
+                        hwloc->topo, in_obj->cpuset, hwloc->obj_depth[t], obj
+                    ))) {
+                ++nobjs;
+            }
+            hwloc->nobjs_in[(i * QUO_OBJ_NTYPES) + t] = nobjs;
+        }
+    }
+    return QUO_SUCCESS;
+}
+
 /* ////////////////////////////////////////////////////////////////////////// */
 static int
 topo_load(quo_hwloc_t *hwloc)
@@ -420,7 +826,80 @@ topo_load(quo_hwloc_t *hwloc)
         qrc = QUO_ERR_TOPO;
         goto out;
     }
+    if (QUO_SUCCESS != (qrc = obj_tables_build(hwloc))) {
+        QUO_ERR_MSGRC("obj_tables_build", qrc);
+        goto out;
+    }
+out:
+    return qrc;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Sets up the node-wide affinity table. Must be called after the topology has
+ * been loaded.
+ */
+static int
+aff_table_setup(quo_hwloc_t *hwloc,
+                quo_mpi_t *mpi)
+{
+    int qrc = QUO_SUCCESS;
+    char *sm_seg_path = NULL;
+    const unsigned bits_per_word = 8 * sizeof(unsigned long);
+
+    if (QUO_SUCCESS != (qrc = quo_mpi_nnoderanks(mpi, &(hwloc->nnoderanks)))) {
+        QUO_ERR_MSGRC("quo_mpi_nnoderanks", qrc);
+        goto out;
+    }
+    /* size entries so that they can hold any cpuset on this machine */
+    int last = quo_internal_hwloc_bitmap_last(
+                   quo_internal_hwloc_topology_get_complete_cpuset(hwloc->topo)
+               );
+    hwloc->aff_nwords = (last < 0) ? 1 : ((unsigned)last / bits_per_word) + 1;
+    hwloc->aff_stride = sizeof(aff_entry_t) +
+                        (hwloc->aff_nwords * sizeof(unsigned long));
+    hwloc->aff_stride = (hwloc->aff_stride + AFF_CACHE_LINE_SIZE - 1) &
+                        ~((size_t)AFF_CACHE_LINE_SIZE - 1);
+    const size_t seg_size = hwloc->nnoderanks * hwloc->aff_stride;
+
+    if (QUO_SUCCESS != (qrc = quo_mpi_xchange_uniq_path(mpi, "aff",
+                                                        &sm_seg_path))) {
+        QUO_ERR_MSGRC("quo_mpi_xchange_uniq_path", qrc);
+        goto out;
+    }
+    /* The segment starts out zeroed, which is a fine initial state. */
+    if (0 == hwloc->nid) {
+        if (QUO_SUCCESS != (qrc = quo_sm_segment_create(hwloc->aff_sm,
+                                                        sm_seg_path,
+                                                        seg_size))) {
+            QUO_ERR_MSGRC("quo_sm_segment_create", qrc);
+            goto out;
+        }
+    }
+    /* Wait for the segment to be created. */
+    if (QUO_SUCCESS != (qrc = quo_mpi_sm_barrier(mpi))) {
+        QUO_ERR_MSGRC("quo_mpi_sm_barrier", qrc);
+        goto out;
+    }
+    if (0 != hwloc->nid) {
+        if (QUO_SUCCESS != (qrc = quo_sm_segment_attach(hwloc->aff_sm,
+                                                        sm_seg_path,
+                                                        seg_size))) {
+            QUO_ERR_MSGRC("quo_sm_segment_attach", qrc);
+            goto out;
+        }
+    }
+    /* Wait for attach completion. */
+    if (QUO_SUCCESS != (qrc = quo_mpi_sm_barrier(mpi))) {
+        QUO_ERR_MSGRC("quo_mpi_sm_barrier", qrc);
+        goto out;
+    }
+    /* Cleanup after everyone is done. */
+    if (0 == hwloc->nid) (void)quo_sm_unlink(hwloc->aff_sm);
+
+    hwloc->aff_entries = (char *)quo_sm_get_basep(hwloc->aff_sm);
 out:
+    if (sm_seg_path) free(sm_seg_path);
     return qrc;
 }
 
@@ -541,12 +1020,22 @@ quo_hwloc_init(quo_hwloc_t *hwloc,
             goto out;
         }
     }
+    /* Setup the node-wide affinity table. */
+    if (QUO_SUCCESS != (qrc = aff_table_setup(hwloc, mpi))) {
+        QUO_ERR_MSGRC("aff_table_setup", qrc);
+        goto out;
+    }
     /* now init some cached attributes that we want to keep around for the
-     * duration of the app's life. */
+     * duration of the app's life. this also publishes our initial binding. */
     if (QUO_SUCCESS != (qrc = init_cached_attrs(hwloc))) {
         QUO_ERR_MSGRC("init_cached_attrs", qrc);
         goto out;
     }
+    /* Make sure that everyone's initial binding is published. */
+    if (QUO_SUCCESS != (qrc = quo_mpi_sm_barrier(mpi))) {
+        QUO_ERR_MSGRC("quo_mpi_sm_barrier", qrc);
+        goto out;
+    }
 out:
     if (qrc != QUO_SUCCESS) {
         (void)quo_hwloc_destruct(hwloc);
@@ -563,9 +1052,14 @@ quo_hwloc_destruct(quo_hwloc_t *hwloc)
 
     quo_internal_hwloc_topology_destroy(hwloc->topo);
     quo_internal_hwloc_bitmap_free(hwloc->widest_cpuset);
-    /* pop initial binding to free up resources */
-    (void)bind_stack_pop(hwloc, NULL);
+    /* free the bind stacks and their pools */
+    bind_stack_free(&hwloc->bstack);
+    bind_stack_free(&hwloc->mbstack);
+    if (hwloc->membufs) free(hwloc->membufs);
     (void)quo_sm_destruct(hwloc->htopo_sm);
+    (void)quo_sm_destruct(hwloc->aff_sm);
+    if (hwloc->obj_table) free(hwloc->obj_table);
+    if (hwloc->nobjs_in) free(hwloc->nobjs_in);
     free(hwloc);
     return QUO_SUCCESS;
 }
@@ -580,44 +1074,54 @@ quo_hwloc_get_nobjs_in_type_by_type(const quo_hwloc_t *hwloc,
 {
     int rc = QUO_ERR;
     quo_internal_hwloc_obj_t obj = NULL;
-    quo_internal_hwloc_cpuset_t cpu_set = NULL;
-    quo_internal_hwloc_obj_type_t real_type = HWLOC_OBJ_MACHINE;
-    int nobjs = 0;
 
     if (!hwloc || !out_result) return QUO_ERR_INVLD_ARG;
     /* set this to something nice just in case an error occurs */
     *out_result = 0;
-    /* now get the "in" object. like: what's the number of PUs *in* the 0th
-     * socket. target_obj in this case corresponds to the 0th socket. */
+    /* validates the "in" object. like: what's the number of PUs *in* the 0th
+     * socket. */
     if (QUO_SUCCESS != (rc = get_obj_by_type(hwloc,
                                              in_type,
                                              in_type_index,
                                              &obj))) {
         return rc;
     }
-    if (NULL == (cpu_set = quo_internal_hwloc_bitmap_alloc())) {
-        QUO_OOR_COMPLAIN();
-        return QUO_ERR_OOR;
+    if (!valid_obj_type(type)) return QUO_ERR_INVLD_ARG;
+    const int in_obj = hwloc->obj_offs[in_type] + in_type_index;
+    *out_result = hwloc->nobjs_in[(in_obj * QUO_OBJ_NTYPES) + type];
+    return QUO_SUCCESS;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Returns the index of the first object of the given type inside the "in"
+ * object, or -1 if there is none. Objects of a type that lie inside another
+ * object have consecutive indices, so this and
+ * quo_hwloc_get_nobjs_in_type_by_type describe all of them.
+ */
+int
+quo_hwloc_get_first_obj_in_type_by_type(const quo_hwloc_t *hwloc,
+                                        QUO_obj_type_t in_type,
+                                        unsigned in_type_index,
+                                        QUO_obj_type_t type,
+                                        int *out_index)
+{
+    int rc = QUO_ERR;
+    quo_internal_hwloc_obj_t in_obj = NULL, obj = NULL;
+
+    if (!hwloc || !out_index) return QUO_ERR_INVLD_ARG;
+    *out_index = -1;
+    if (QUO_SUCCESS != (rc = get_obj_by_type(hwloc, in_type, in_type_index,
+                                             &in_obj))) {
+        return rc;
     }
-    /* copy the cpuset of the in target -- do we need this? */
-    quo_internal_hwloc_bitmap_copy(cpu_set, obj->cpuset);
-    if (QUO_SUCCESS != (rc = ext2intobj(type, &real_type))) goto out;
-    /* set to NULL so the next call works properly */
-    obj = NULL;
-    /* now count */
-    while ((obj = quo_internal_hwloc_get_next_obj_inside_cpuset_by_type(
-                      hwloc->topo,
-                      cpu_set,
-                      real_type,
-                      obj
-                  ))) {
-        ++nobjs;
-    }
-    *out_result = nobjs;
-out:
-    if (cpu_set) quo_internal_hwloc_bitmap_free(cpu_set);
-    if (QUO_SUCCESS != rc) *out_result = 0;
-    return rc;
+    if (!valid_obj_type(type)) return QUO_ERR_INVLD_ARG;
+    if (hwloc->obj_depth[type] < 0) return QUO_SUCCESS;
+    obj = quo_internal_hwloc_get_next_obj_inside_cpuset_by_depth(
+              hwloc->topo, in_obj->cpuset, hwloc->obj_depth[type], NULL
+          );
+    if (obj) *out_index = (int)obj->logical_index;
+    return QUO_SUCCESS;
 }
 
 /* ////////////////////////////////////////////////////////////////////////// */
@@ -629,19 +1133,9 @@ quo_hwloc_get_nobjs_by_type(const quo_hwloc_t *hwloc,
                             QUO_obj_type_t target_type,
                             int *out_nobjs)
 {
-    int depth = 0, rc = QUO_ERR;
-    quo_internal_hwloc_obj_type_t real_type = HWLOC_OBJ_MACHINE;
-
     if (!hwloc || !out_nobjs) return QUO_ERR_INVLD_ARG;
-    if (QUO_SUCCESS != (rc = ext2intobj(target_type, &real_type))) return rc;
-    depth = quo_internal_hwloc_get_type_depth(hwloc->topo, real_type);
-    if (HWLOC_TYPE_DEPTH_UNKNOWN == depth) {
-        /* hwloc can't determine the number of x, so just return 0 */
-        *out_nobjs = 0;
-    }
-    else {
-        *out_nobjs = quo_internal_hwloc_get_nbobjs_by_depth(hwloc->topo, depth);
-    }
+    if (!valid_obj_type(target_type)) return QUO_ERR_INVLD_ARG;
+    *out_nobjs = hwloc->nobjs[target_type];
     return QUO_SUCCESS;
 }
 
@@ -655,109 +1149,448 @@ quo_hwloc_is_in_cpuset_by_type_id(const quo_hwloc_t *hwloc,
 {
     int rc = QUO_ERR;
     quo_internal_hwloc_obj_t obj = NULL;
-    quo_internal_hwloc_cpuset_t cur_bind = NULL;
+    unsigned long stack_words[AFF_STACK_NWORDS], *cur_bind = NULL;
+    unsigned long hits = 0;
 
     if (!hwloc || !out_result) return QUO_ERR_INVLD_ARG;
     if (QUO_SUCCESS != (rc = get_obj_by_type(hwloc, type, type_index, &obj))) {
         return rc;
     }
-    if (QUO_SUCCESS != (rc = get_cur_bind(hwloc, pid, &cur_bind))) return rc;
-    *out_result = quo_internal_hwloc_bitmap_intersects(cur_bind, obj->cpuset);
-    quo_internal_hwloc_bitmap_free(cur_bind);
-    return QUO_SUCCESS;
+    if (NULL == (cur_bind = aff_words_get(hwloc, stack_words))) {
+        return QUO_ERR_OOR;
+    }
+    if (QUO_SUCCESS != (rc = read_cur_bind(hwloc, pid, cur_bind))) goto out;
+    for (unsigned i = 0; i < hwloc->aff_nwords; ++i) {
+        hits |= cur_bind[i] &
+                quo_internal_hwloc_bitmap_to_ith_ulong(obj->cpuset, i);
+    }
+    *out_result = (0 != hits);
+out:
+    aff_words_put(cur_bind, stack_words);
+    return rc;
 }
 
 /* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Returns the node-local IDs of the processes whose published binding
+ * intersects the given object's cpuset. out_qids must be able to hold one
+ * entry per node-local process.
+ */
 int
-quo_hwloc_bound(const quo_hwloc_t *hwloc,
-                pid_t pid,
-                bool *out_bound)
+quo_hwloc_qids_in_type(const quo_hwloc_t *hwloc,
+                       QUO_obj_type_t type,
+                       unsigned type_index,
+                       int *out_nqids,
+                       int *out_qids)
 {
-    int rc = 0;
-    quo_internal_hwloc_cpuset_t cur_bind = NULL;
-
-    if (NULL == hwloc || NULL == out_bound) return QUO_ERR_INVLD_ARG;
+    int rc = QUO_SUCCESS, nqids = 0;
+    quo_internal_hwloc_obj_t obj = NULL;
 
-    if (QUO_SUCCESS != (rc = get_cur_bind(hwloc, pid, &cur_bind))) {
-        goto out;
+    if (!hwloc || !out_nqids || !out_qids) return QUO_ERR_INVLD_ARG;
+    *out_nqids = 0;
+    if (QUO_SUCCESS != (rc = get_obj_by_type(hwloc, type, type_index, &obj))) {
+        return rc;
     }
-    /* if our current binding isn't equal to the widest, then we are bound to
-     * something smaller than the widest. so, at least as far as we are
-     * concerned, the process is "bound." */
-    *out_bound = !quo_internal_hwloc_bitmap_isequal(hwloc->widest_cpuset,
-                                                    cur_bind);
-out:
-    if (cur_bind) quo_internal_hwloc_bitmap_free(cur_bind);
-    return rc;
+    for (int qid = 0; qid < hwloc->nnoderanks; ++qid) {
+        if (aff_intersects(hwloc, qid, obj->cpuset)) out_qids[nqids++] = qid;
+    }
+    *out_nqids = nqids;
+    return QUO_SUCCESS;
 }
 
 /* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Mask flavor of quo_hwloc_qids_in_type. out_mask must be able to hold one bit
+ * per node-local process.
+ */
 int
-quo_hwloc_stringify_cbind(const quo_hwloc_t *hwloc,
-                          pid_t pid,
-                          char **out_str)
+quo_hwloc_qids_in_type_mask(const quo_hwloc_t *hwloc,
+                            QUO_obj_type_t type,
+                            unsigned type_index,
+                            uint64_t *out_mask,
+                            unsigned nwords)
 {
     int rc = QUO_SUCCESS;
-    quo_internal_hwloc_cpuset_t cur_bind = NULL;
+    quo_internal_hwloc_obj_t obj = NULL;
 
-    if (!hwloc || !out_str) return QUO_ERR_INVLD_ARG;
+    if (!hwloc || !out_mask) return QUO_ERR_INVLD_ARG;
+    if ((unsigned)hwloc->nnoderanks > 64 * nwords) return QUO_ERR_INVLD_ARG;
+    memset(out_mask, 0, nwords * sizeof(*out_mask));
+    if (QUO_SUCCESS != (rc = get_obj_by_type(hwloc, type, type_index, &obj))) {
+        return rc;
+    }
+    for (int qid = 0; qid < hwloc->nnoderanks; ++qid) {
+        if (aff_intersects(hwloc, qid, obj->cpuset)) {
+            out_mask[qid / 64] |= (uint64_t)1 << (qid % 64);
+        }
+    }
+    return QUO_SUCCESS;
+}
 
-    if (QUO_SUCCESS != (rc = get_cur_bind(hwloc, pid, &cur_bind))) {
-        /* get_cur_bind cleans up after itself on failure */
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Returns how many PUs of the given object the published binding of qid covers
+ * (out_noverlap) and how many PUs that binding covers in total (out_nbound).
+ */
+int
+quo_hwloc_qid_overlap(const quo_hwloc_t *hwloc,
+                      int qid,
+                      QUO_obj_type_t type,
+                      unsigned type_index,
+                      int *out_noverlap,
+                      int *out_nbound)
+{
+    int rc = QUO_SUCCESS, noverlap = 0, nbound = 0;
+    quo_internal_hwloc_obj_t obj = NULL;
+    unsigned long stack_words[AFF_STACK_NWORDS], *words = NULL;
+
+    if (!hwloc || !out_noverlap || !out_nbound) return QUO_ERR_INVLD_ARG;
+    if (qid < 0 || qid >= hwloc->nnoderanks) return QUO_ERR_INVLD_ARG;
+    if (QUO_SUCCESS != (rc = get_obj_by_type(hwloc, type, type_index, &obj))) {
         return rc;
     }
+    if (NULL == (words = aff_words_get(hwloc, stack_words))) {
+        return QUO_ERR_OOR;
+    }
+    aff_read(hwloc, qid, words);
+    for (unsigned i = 0; i < hwloc->aff_nwords; ++i) {
+        unsigned long objw = quo_internal_hwloc_bitmap_to_ith_ulong(obj->cpuset,
+                                                                    i);
+        nbound += __builtin_popcountl(words[i]);
+        noverlap += __builtin_popcountl(words[i] & objw);
+    }
+    aff_words_put(words, stack_words);
+    *out_noverlap = noverlap;
+    *out_nbound = nbound;
+    return QUO_SUCCESS;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Returns a digest (64-bit FNV-1a) of the binding I published in the node-wide
+ * affinity table. Only I change my entry, so the digest stays put until I push
+ * or pop, and a return to an earlier binding gives back the earlier digest.
+ */
+int
+quo_hwloc_bind_digest(const quo_hwloc_t *hwloc,
+                      uint64_t *out_digest)
+{
+    unsigned long stack_words[AFF_STACK_NWORDS], *words = NULL;
+    uint64_t digest = 14695981039346656037ULL;
+
+    if (!hwloc || !out_digest) return QUO_ERR_INVLD_ARG;
+    if (NULL == (words = aff_words_get(hwloc, stack_words))) {
+        return QUO_ERR_OOR;
+    }
+    aff_read(hwloc, hwloc->nid, words);
+    for (unsigned i = 0; i < hwloc->aff_nwords; ++i) {
+        for (unsigned b = 0; b < sizeof(words[i]); ++b) {
+            digest ^= (words[i] >> (8 * b)) & 0xff;
+            digest *= 1099511628211ULL;
+        }
+    }
+    aff_words_put(words, stack_words);
+    *out_digest = digest;
+    return QUO_SUCCESS;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Packs the current binding of the given process into 64-bit words. Bits past
+ * the provided words are dropped.
+ */
+int
+quo_hwloc_get_cur_bind_words(const quo_hwloc_t *hwloc,
+                             pid_t pid,
+                             uint64_t *words,
+                             unsigned nwords)
+{
+    int rc = QUO_SUCCESS;
+    const unsigned bits_per_word = 8 * sizeof(unsigned long);
+    unsigned long stack_words[AFF_STACK_NWORDS], *cur_bind = NULL;
+
+    if (!hwloc || !words) return QUO_ERR_INVLD_ARG;
+    if (NULL == (cur_bind = aff_words_get(hwloc, stack_words))) {
+        return QUO_ERR_OOR;
+    }
+    if (QUO_SUCCESS != (rc = read_cur_bind(hwloc, pid, cur_bind))) goto out;
+    memset(words, 0, nwords * sizeof(*words));
+    for (unsigned i = 0; i < hwloc->aff_nwords; ++i) {
+        for (unsigned long w = cur_bind[i]; 0 != w; w &= w - 1) {
+            unsigned bit = (i * bits_per_word) + __builtin_ctzl(w);
+            if (bit >= 64 * nwords) goto out;
+            words[bit / 64] |= (uint64_t)1 << (bit % 64);
+        }
+    }
+out:
+    aff_words_put(cur_bind, stack_words);
+    return rc;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+quo_hwloc_bound(const quo_hwloc_t *hwloc,
+                pid_t pid,
+                bool *out_bound)
+{
+    int rc = 0;
+    unsigned long stack_words[AFF_STACK_NWORDS], *cur_bind = NULL;
+
+    if (NULL == hwloc || NULL == out_bound) return QUO_ERR_INVLD_ARG;
+
+    if (NULL == (cur_bind = aff_words_get(hwloc, stack_words))) {
+        return QUO_ERR_OOR;
+    }
+    if (QUO_SUCCESS != (rc = read_cur_bind(hwloc, pid, cur_bind))) goto out;
+    /* if our current binding isn't equal to the widest, then we are bound to
+     * something smaller than the widest. so, at least as far as we are
+     * concerned, the process is "bound." */
+    *out_bound = false;
+    for (unsigned i = 0; i < hwloc->aff_nwords; ++i) {
+        if (cur_bind[i] !=
+            quo_internal_hwloc_bitmap_to_ith_ulong(hwloc->widest_cpuset, i)) {
+            *out_bound = true;
+            break;
+        }
+    }
+out:
+    aff_words_put(cur_bind, stack_words);
+    return rc;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+quo_hwloc_stringify_cbind(const quo_hwloc_t *hwloc,
+                          pid_t pid,
+                          char **out_str)
+{
+    int rc = QUO_SUCCESS;
+    unsigned long stack_words[AFF_STACK_NWORDS], *words = NULL;
+    quo_internal_hwloc_cpuset_t cur_bind = NULL;
+
+    if (!hwloc || !out_str) return QUO_ERR_INVLD_ARG;
+
+    if (NULL == (words = aff_words_get(hwloc, stack_words))) {
+        return QUO_ERR_OOR;
+    }
+    if (QUO_SUCCESS != (rc = read_cur_bind(hwloc, pid, words))) goto out;
+    if (NULL == (cur_bind = quo_internal_hwloc_bitmap_alloc())) {
+        QUO_OOR_COMPLAIN();
+        rc = QUO_ERR_OOR;
+        goto out;
+    }
+    for (unsigned i = 0; i < hwloc->aff_nwords; ++i) {
+        quo_internal_hwloc_bitmap_set_ith_ulong(cur_bind, i, words[i]);
+    }
     /* caller is responsible for freeing returned resources */
-    quo_internal_hwloc_bitmap_asprintf(out_str, cur_bind);
-    if (!out_str) {
+    if (-1 == quo_internal_hwloc_bitmap_asprintf(out_str, cur_bind)) {
         QUO_OOR_COMPLAIN();
         rc = QUO_ERR_OOR;
     }
+out:
     if (cur_bind) quo_internal_hwloc_bitmap_free(cur_bind);
+    aff_words_put(words, stack_words);
     return rc;
 }
 
 /* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Changes our binding to the given cpuset. If it matches the current binding
+ * and no thread was bound since, no system call is made and *out_rebound is
+ * false.
+ */
+static int
+rebind_cpuset(const quo_hwloc_t *hwloc,
+              quo_internal_hwloc_const_cpuset_t target,
+              bool *out_rebound)
+{
+    int rc = QUO_SUCCESS;
+    quo_internal_hwloc_const_cpuset_t curbind = NULL;
+    quo_internal_hwloc_cpuset_t tofree = NULL;
+
+    if (!hwloc || !target || !out_rebound) return QUO_ERR_INVLD_ARG;
+    *out_rebound = false;
+    /* already there? then there is nothing to do */
+    if (QUO_SUCCESS != (rc = get_cur_bind_ref(hwloc, hwloc->mypid,
+                                              &curbind, &tofree))) {
+        goto out;
+    }
+    if (!QUO_ATOMIC_LOAD_RLX(&hwloc->thread_bound) &&
+        quo_internal_hwloc_bitmap_isequal(curbind, target)) {
+        goto out;
+    }
+    /* set the policy */
+    if (-1 == quo_internal_hwloc_set_cpubind(hwloc->topo, target,
+                                             HWLOC_CPUBIND_PROCESS)) {
+        rc = QUO_ERR_NOT_SUPPORTED;
+        goto out;
+    }
+    *out_rebound = true;
+out:
+    if (tofree) quo_internal_hwloc_bitmap_free(tofree);
+    return rc;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Lays out the PUs in cpuset core by core. The PUs (by OS index) of the c-th
+ * core that intersects cpuset are (*out_pus)[(*out_core_offs)[c]] up to, but
+ * not including, (*out_pus)[(*out_core_offs)[c + 1]]. PUs that are not in any
+ * core (e.g. there is no core level) are cores of their own. Caller is
+ * responsible for freeing *out_core_offs and *out_pus.
+ */
+static int
+smt_layout(const quo_hwloc_t *hwloc,
+           quo_internal_hwloc_const_cpuset_t cpuset,
+           int *out_ncores,
+           int **out_core_offs,
+           int **out_pus)
+{
+    int rc = QUO_SUCCESS, npus = 0, ncores = 0, n = 0;
+    int *core_offs = NULL, *pus = NULL;
+    quo_internal_hwloc_cpuset_t tmp = NULL, rest = NULL;
+
+    if (0 >= (npus = quo_internal_hwloc_bitmap_weight(cpuset))) {
+        return QUO_ERR_INVLD_ARG;
+    }
+    if (NULL == (core_offs = calloc(npus + 1, sizeof(*core_offs))) ||
+        NULL == (pus = calloc(npus, sizeof(*pus))) ||
+        NULL == (tmp = quo_internal_hwloc_bitmap_alloc()) ||
+        NULL == (rest = quo_internal_hwloc_bitmap_dup(cpuset))) {
+        QUO_OOR_COMPLAIN();
+        rc = QUO_ERR_OOR;
+        goto out;
+    }
+    for (int c = 0; c < hwloc->nobjs[QUO_OBJ_CORE]; ++c) {
+        quo_internal_hwloc_obj_t core =
+            hwloc->obj_table[hwloc->obj_offs[QUO_OBJ_CORE] + c];
+        quo_internal_hwloc_bitmap_and(tmp, core->cpuset, cpuset);
+        if (quo_internal_hwloc_bitmap_iszero(tmp)) continue;
+        quo_internal_hwloc_bitmap_andnot(rest, rest, tmp);
+        core_offs[ncores++] = n;
+        for (int id = quo_internal_hwloc_bitmap_first(tmp); -1 != id;
+             id = quo_internal_hwloc_bitmap_next(tmp, id)) {
+            pus[n++] = id;
+        }
+    }
+    for (int id = quo_internal_hwloc_bitmap_first(rest); -1 != id;
+         id = quo_internal_hwloc_bitmap_next(rest, id)) {
+        core_offs[ncores++] = n;
+        pus[n++] = id;
+    }
+    core_offs[ncores] = n;
+    *out_ncores = ncores;
+    *out_core_offs = core_offs;
+    *out_pus = pus;
+out:
+    if (QUO_SUCCESS != rc) {
+        if (core_offs) free(core_offs);
+        if (pus) free(pus);
+    }
+    if (tmp) quo_internal_hwloc_bitmap_free(tmp);
+    if (rest) quo_internal_hwloc_bitmap_free(rest);
+    return rc;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Sets *out_cpuset to the part of cpuset that the SMT policy lets process
+ * bindings use: all of it, or only the first PU of every core. Caller is
+ * responsible for freeing *out_cpuset.
+ */
+static int
+smt_restrict(const quo_hwloc_t *hwloc,
+             quo_internal_hwloc_const_cpuset_t cpuset,
+             quo_internal_hwloc_cpuset_t *out_cpuset)
+{
+    int rc = QUO_SUCCESS, ncores = 0;
+    int *core_offs = NULL, *pus = NULL;
+
+    if (NULL == (*out_cpuset = quo_internal_hwloc_bitmap_dup(cpuset))) {
+        QUO_OOR_COMPLAIN();
+        return QUO_ERR_OOR;
+    }
+    if (QUO_SMT_ONE_PU_PER_CORE != hwloc->smt_policy) return QUO_SUCCESS;
+
+    if (QUO_SUCCESS != (rc = smt_layout(hwloc, cpuset, &ncores,
+                                        &core_offs, &pus))) {
+        quo_internal_hwloc_bitmap_free(*out_cpuset);
+        *out_cpuset = NULL;
+        return rc;
+    }
+    quo_internal_hwloc_bitmap_zero(*out_cpuset);
+    for (int c = 0; c < ncores; ++c) {
+        quo_internal_hwloc_bitmap_set(*out_cpuset, pus[core_offs[c]]);
+    }
+    free(core_offs);
+    free(pus);
+    return QUO_SUCCESS;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Changes our binding according to the given policy.
+ */
 static int
 rebind(const quo_hwloc_t *hwloc,
        QUO_bind_push_policy_t policy,
        QUO_obj_type_t type,
-       unsigned obj_index)
+       unsigned obj_index,
+       bool *out_rebound)
 {
     int rc = QUO_SUCCESS;
     quo_internal_hwloc_obj_t target_obj = NULL;
-    quo_internal_hwloc_cpuset_t cpuset = NULL;
+    quo_internal_hwloc_cpuset_t target = NULL;
 
-    if (!hwloc) return QUO_ERR_INVLD_ARG;
+    if (!hwloc || !out_rebound) return QUO_ERR_INVLD_ARG;
     /* now get the appropriate object based on the given policy */
     if (QUO_BIND_PUSH_PROVIDED == policy) {
         rc = get_obj_by_type(hwloc, type, obj_index, &target_obj);
     }
-    else if (QUO_BIND_PUSH_OBJ) {
+    else if (QUO_BIND_PUSH_OBJ == policy) {
         /* get_obj_covering_cur_bind ignores obj_index */
         rc = get_obj_covering_cur_bind(hwloc, type, &target_obj);
     }
     else {
         rc = QUO_ERR_INVLD_ARG;
     }
-    if (QUO_SUCCESS != rc) goto out;
-    /* now allocate and copy the given obj's cpuset */
-    if (NULL == (cpuset = quo_internal_hwloc_bitmap_alloc())) {
-        return QUO_ERR_OOR;
-    }
-    /* make a copy of the obj's cpuset */
-    quo_internal_hwloc_bitmap_copy(cpuset, target_obj->cpuset);
-    /* set the policy */
-    if (-1 == quo_internal_hwloc_set_cpubind(hwloc->topo,
-                                             cpuset,
-                                             HWLOC_CPUBIND_PROCESS)) {
-        rc = QUO_ERR_NOT_SUPPORTED;
-        goto out;
+    if (QUO_SUCCESS != rc) return rc;
+    if (QUO_SUCCESS != (rc = smt_restrict(hwloc, target_obj->cpuset,
+                                          &target))) {
+        return rc;
     }
-out:
-    if (cpuset) quo_internal_hwloc_bitmap_free(cpuset);
+    rc = rebind_cpuset(hwloc, target, out_rebound);
+    quo_internal_hwloc_bitmap_free(target);
     return rc;
 }
 
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Pushes the binding we just switched to (via rebind or rebind_cpuset).
+ */
+static int
+push_rebind(quo_hwloc_t *hwloc,
+            bool rebound)
+{
+    int rc = QUO_SUCCESS;
+
+    /* unchanged binding: duplicate the top; nobody needs to hear about it */
+    if (!rebound && !hwloc->revalidate_bind && hwloc->bstack.top > 0) {
+        return bind_stack_push(
+                   &hwloc->bstack,
+                   hwloc->bstack.bind_stack[hwloc->bstack.top - 1], 0
+               );
+    }
+    /* stash our shiny new binding */
+    if (QUO_SUCCESS != (rc = push_cur_bind(hwloc))) return rc;
+    if (rebound) {
+        hwloc->bind_epoch++;
+        /* the process binding replaced all thread bindings */
+        QUO_ATOMIC_STORE_RLX(&hwloc->thread_bound, false);
+    }
+    return QUO_SUCCESS;
+}
+
 /* ////////////////////////////////////////////////////////////////////////// */
 int
 quo_hwloc_bind_push(quo_hwloc_t *hwloc,
@@ -766,6 +1599,7 @@ quo_hwloc_bind_push(quo_hwloc_t *hwloc,
                     unsigned obj_index)
 {
     int rc = QUO_SUCCESS;
+    bool rebound = false;
 
     if (!hwloc) return QUO_ERR_INVLD_ARG;
     /* make sure that we are dealing with a valid policy */
@@ -774,11 +1608,101 @@ quo_hwloc_bind_push(quo_hwloc_t *hwloc,
         return QUO_ERR_INVLD_ARG;
     }
     /* change binding */
-    if (QUO_SUCCESS != (rc = rebind(hwloc, policy, type, obj_index))) {
+    if (QUO_SUCCESS != (rc = rebind(hwloc, policy, type, obj_index,
+                                    &rebound))) {
         return rc;
     }
-    /* stash our shiny new binding */
-    return push_cur_bind(hwloc);
+    return push_rebind(hwloc, rebound);
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Binds to the given cpuset after making sure that it is a non-empty subset
+ * of the machine's.
+ */
+static int
+bind_push_cpuset(quo_hwloc_t *hwloc,
+                 quo_internal_hwloc_const_cpuset_t cpuset)
+{
+    int rc = QUO_SUCCESS;
+    bool rebound = false;
+
+    if (quo_internal_hwloc_bitmap_iszero(cpuset) ||
+        !quo_internal_hwloc_bitmap_isincluded(cpuset, hwloc->widest_cpuset)) {
+        QUO_ERR_MSG("cpuset is empty or not within the machine's cpuset");
+        return QUO_ERR_INVLD_ARG;
+    }
+    if (QUO_SUCCESS != (rc = rebind_cpuset(hwloc, cpuset, &rebound))) {
+        return rc;
+    }
+    return push_rebind(hwloc, rebound);
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+quo_hwloc_bind_push_cpuset(quo_hwloc_t *hwloc,
+                           const char *cpuset_str)
+{
+    int rc = QUO_SUCCESS;
+    quo_internal_hwloc_cpuset_t cpuset = NULL;
+
+    if (!hwloc || !cpuset_str) return QUO_ERR_INVLD_ARG;
+
+    if (NULL == (cpuset = quo_internal_hwloc_bitmap_alloc())) {
+        QUO_OOR_COMPLAIN();
+        return QUO_ERR_OOR;
+    }
+    /* hwloc's mask format (e.g. 0x000000f0) or list format (e.g. 4-7,12) */
+    if (strchr(cpuset_str, 'x')) {
+        rc = quo_internal_hwloc_bitmap_sscanf(cpuset, cpuset_str);
+    }
+    else rc = quo_internal_hwloc_bitmap_list_sscanf(cpuset, cpuset_str);
+    if (0 != rc) {
+        QUO_ERR_MSG("cannot parse cpuset string");
+        rc = QUO_ERR_INVLD_ARG;
+        goto out;
+    }
+    rc = bind_push_cpuset(hwloc, cpuset);
+out:
+    quo_internal_hwloc_bitmap_free(cpuset);
+    return rc;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+quo_hwloc_bind_push_objs(quo_hwloc_t *hwloc,
+                         const QUO_obj_type_t *types,
+                         const int *obj_indices,
+                         int nobjs)
+{
+    int rc = QUO_SUCCESS;
+    quo_internal_hwloc_cpuset_t cpuset = NULL;
+
+    if (!hwloc || !types || !obj_indices || nobjs <= 0) {
+        return QUO_ERR_INVLD_ARG;
+    }
+    if (NULL == (cpuset = quo_internal_hwloc_bitmap_alloc())) {
+        QUO_OOR_COMPLAIN();
+        return QUO_ERR_OOR;
+    }
+    /* the union of all the objects */
+    for (int i = 0; i < nobjs; ++i) {
+        quo_internal_hwloc_obj_t obj = NULL;
+        if (obj_indices[i] < 0) {
+            rc = QUO_ERR_INVLD_ARG;
+            goto out;
+        }
+        if (QUO_SUCCESS != (rc = get_obj_by_type(hwloc, types[i],
+                                                 (unsigned)obj_indices[i],
+                                                 &obj))) {
+            goto out;
+        }
+        quo_internal_hwloc_bitmap_or(cpuset, cpuset, obj->cpuset);
+    }
+    rc = bind_push_cpuset(hwloc, cpuset);
+out:
+    quo_internal_hwloc_bitmap_free(cpuset);
+    return rc;
 }
 
 /* ////////////////////////////////////////////////////////////////////////// */
@@ -786,144 +1710,508 @@ int
 quo_hwloc_bind_pop(quo_hwloc_t *hwloc)
 {
     int rc = QUO_SUCCESS;
-    quo_internal_hwloc_cpuset_t topbind = NULL;
+    quo_internal_hwloc_const_cpuset_t topbind = NULL;
 
     if (!hwloc) return QUO_ERR_INVLD_ARG;
-    if (QUO_SUCCESS != (rc = bind_stack_pop(hwloc, NULL))) return rc;
+    if (QUO_SUCCESS != (rc = bind_stack_pop(&hwloc->bstack, NULL))) return rc;
     /* revert to the top binding after pop (the previous binding) */
-    if (QUO_SUCCESS != (rc = bind_stack_top(hwloc, &topbind))) goto out;
+    if (QUO_SUCCESS != (rc = bind_stack_top(&hwloc->bstack, &topbind))) {
+        return rc;
+    }
+    /* the popped binding is still in the pool right above the new top. if the
+     * two match (and no thread was bound since), then our binding does not
+     * change. */
+    if (!hwloc->revalidate_bind && !QUO_ATOMIC_LOAD_RLX(&hwloc->thread_bound) &&
+        quo_internal_hwloc_bitmap_isequal(
+            topbind, hwloc->bstack.bind_stack[hwloc->bstack.top]
+        )) {
+        return QUO_SUCCESS;
+    }
     if (-1 == quo_internal_hwloc_set_cpubind(hwloc->topo, topbind,
                                              HWLOC_CPUBIND_PROCESS)) {
-        rc = QUO_ERR_NOT_SUPPORTED;
+        return QUO_ERR_NOT_SUPPORTED;
+    }
+    hwloc->bind_epoch++;
+    QUO_ATOMIC_STORE_RLX(&hwloc->thread_bound, false);
+    /* let everyone on the node know */
+    aff_publish(hwloc, topbind);
+    return QUO_SUCCESS;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Returns the number of resident bytes of the given buffer that live on NUMA
+ * nodes outside of the given nodeset, or 0 if that cannot be determined.
+ */
+static size_t
+membuf_nbytes_off(const membuf_t *buf,
+                  quo_internal_hwloc_const_nodeset_t nodeset)
+{
+    size_t nbytes = 0;
+#ifdef SYS_move_pages
+    const uintptr_t pgsize = (uintptr_t)sysconf(_SC_PAGESIZE);
+    const uintptr_t first = (uintptr_t)buf->addr & ~(pgsize - 1);
+    const uintptr_t end = (uintptr_t)buf->addr + buf->len;
+    const unsigned long npages = (end - first + pgsize - 1) / pgsize;
+    void **pages = NULL;
+    int *status = NULL;
+
+    if (0 == buf->len) return 0;
+    pages = calloc(npages, sizeof(*pages));
+    status = calloc(npages, sizeof(*status));
+    if (!pages || !status) goto out;
+    for (unsigned long i = 0; i < npages; ++i) {
+        pages[i] = (void *)(first + i * pgsize);
+    }
+    /* no target nodes: just ask where the pages are */
+    if (0 != syscall(SYS_move_pages, 0, npages, pages, NULL, status, 0)) {
         goto out;
     }
+    for (unsigned long i = 0; i < npages; ++i) {
+        /* negative status: not resident (or not ours to look at) */
+        if (status[i] >= 0 &&
+            !quo_internal_hwloc_bitmap_isset(nodeset, (unsigned)status[i])) {
+            nbytes += pgsize;
+        }
+    }
 out:
-    if (topbind) quo_internal_hwloc_bitmap_free(topbind);
+    if (pages) free(pages);
+    if (status) free(status);
+#else
+    QUO_UNUSED(buf);
+    QUO_UNUSED(nodeset);
+#endif
+    return nbytes;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Returns the number of resident bytes of the whole process that live on NUMA
+ * nodes outside of the given nodeset, or 0 if that cannot be determined.
+ */
+static size_t
+proc_nbytes_off(quo_internal_hwloc_const_nodeset_t nodeset)
+{
+    size_t nbytes = 0, linecap = 0;
+    char *line = NULL;
+    FILE *maps = NULL;
+
+    if (NULL == (maps = fopen("/proc/self/numa_maps", "r"))) return 0;
+    /* lines look like: 7f..000 default anon=3 dirty=3 N0=3 kernelpagesize_kB=4 */
+    while (-1 != getline(&line, &linecap, maps)) {
+        size_t npages = 0, pgsize_kb = 4;
+        char *save = NULL;
+        for (char *tok = strtok_r(line, " \n", &save); tok;
+             tok = strtok_r(NULL, " \n", &save)) {
+            unsigned node = 0;
+            size_t n = 0;
+            if (2 == sscanf(tok, "N%u=%zu", &node, &n)) {
+                if (!quo_internal_hwloc_bitmap_isset(nodeset, node)) {
+                    npages += n;
+                }
+            }
+            else (void)sscanf(tok, "kernelpagesize_kB=%zu", &pgsize_kb);
+        }
+        nbytes += npages * pgsize_kb * 1024;
+    }
+    if (line) free(line);
+    fclose(maps);
+    return nbytes;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Applies the memory binding stored at index i of the memory bind stack. When
+ * migrate is set, also moves either the registered buffers or, if there are
+ * none, the whole process to the new nodes and records how much was moved.
+ */
+static int
+membind_apply(quo_hwloc_t *hwloc,
+              int i,
+              bool migrate)
+{
+    const bind_stack_t *bs = &hwloc->mbstack;
+    quo_internal_hwloc_const_nodeset_t nodeset = bs->bind_stack[i];
+    quo_internal_hwloc_membind_policy_t policy = HWLOC_MEMBIND_BIND;
+    const bool whole_proc = migrate && 0 == hwloc->nmembufs;
+    int rc = QUO_SUCCESS, flags = 0;
+    size_t before = 0, nbytes = 0;
+    double start = 0.0;
+
+    if (0 == i) policy = hwloc->membind_base_policy;
+    if (bs->flags[i] & QUO_MEMBIND_STRICT) flags |= HWLOC_MEMBIND_STRICT;
+    if (migrate) start = MPI_Wtime();
+    if (whole_proc) before = proc_nbytes_off(nodeset);
+    if (-1 == quo_internal_hwloc_set_membind_nodeset(
+                  hwloc->topo, nodeset, policy,
+                  flags | (whole_proc ? HWLOC_MEMBIND_MIGRATE : 0)
+              )) {
+        return QUO_ERR_NOT_SUPPORTED;
+    }
+    if (!migrate) return QUO_SUCCESS;
+    if (whole_proc) {
+        const size_t after = proc_nbytes_off(nodeset);
+        if (before > after) nbytes = before - after;
+    }
+    for (int b = 0; b < hwloc->nmembufs; ++b) {
+        const membuf_t *buf = &hwloc->membufs[b];
+        before = membuf_nbytes_off(buf, nodeset);
+        if (-1 == quo_internal_hwloc_set_area_membind_nodeset(
+                      hwloc->topo, buf->addr, buf->len, nodeset, policy,
+                      flags | HWLOC_MEMBIND_MIGRATE
+                  )) {
+            rc = QUO_ERR_NOT_SUPPORTED;
+            break;
+        }
+        const size_t after = membuf_nbytes_off(buf, nodeset);
+        if (before > after) nbytes += before - after;
+    }
+    hwloc->migrate_nbytes = nbytes;
+    hwloc->migrate_secs = MPI_Wtime() - start;
     return rc;
 }
 
 /* ////////////////////////////////////////////////////////////////////////// */
 int
-quo_hwloc_bind_threads(quo_hwloc_t *hwloc,
-                       int qid,
-                       int qids_in_type,
-                       int omp_thread,
-                       int num_omp_threads)
+quo_hwloc_membind_push(quo_hwloc_t *hwloc,
+                       int flags)
 {
-    // TODO FIXME
-#if 1
-    QUO_UNUSED(hwloc);
-    QUO_UNUSED(qid);
-    QUO_UNUSED(qids_in_type);
-    QUO_UNUSED(omp_thread);
-    QUO_UNUSED(num_omp_threads);
-    return QUO_ERR_NOT_SUPPORTED;
-#else
-    hwloc_cpuset_t set;
-    cpu_set_t new_set;
-    int cpu, total, count = 0;
-    double cpu_per_thread;
-    unsigned i;
-    double min;
-    double max;
-    int rc = QUO_ERR;
-
-    if(QUO_SUCCESS != (rc = get_cur_bind(hwloc, hwloc->mypid, &set))) return rc;
-    if(QUO_SUCCESS != (rc = quo_hwloc_get_nobjs_by_type(hwloc,
-                                                        QUO_OBJ_PU, &total)))
-        return rc;
+    int rc = QUO_SUCCESS;
+    bind_stack_t *bs = NULL;
+    quo_internal_hwloc_const_cpuset_t curbind = NULL;
+    quo_internal_hwloc_cpuset_t tofree = NULL;
+    quo_internal_hwloc_nodeset_t nodeset = NULL;
 
-    for (i = 0; i < total; i++)
-        count += hwloc_bitmap_isset(set, i);
+    if (!hwloc) return QUO_ERR_INVLD_ARG;
+    if (flags & ~(QUO_MEMBIND_STRICT | QUO_MEMBIND_MIGRATE)) {
+        QUO_ERR_MSG("invalid flags");
+        return QUO_ERR_INVLD_ARG;
+    }
+    bs = &hwloc->mbstack;
+    /* first push: remember what we are starting from */
+    if (0 == bs->top) {
+        if (QUO_SUCCESS != (rc = bind_stack_reserve(bs))) return rc;
+        if (-1 == quo_internal_hwloc_get_membind_nodeset(
+                      hwloc->topo, bs->bind_stack[0],
+                      &hwloc->membind_base_policy, 0
+                  )) {
+            return QUO_ERR_NOT_SUPPORTED;
+        }
+        bs->flags[0] = 0;
+        bs->top = 1;
+    }
+    if (NULL == (nodeset = quo_internal_hwloc_bitmap_alloc())) {
+        QUO_OOR_COMPLAIN();
+        return QUO_ERR_OOR;
+    }
+    /* the NUMA nodes of our current cpu binding */
+    if (QUO_SUCCESS != (rc = get_cur_bind_ref(hwloc, hwloc->mypid,
+                                              &curbind, &tofree))) {
+        goto out;
+    }
+    quo_internal_hwloc_cpuset_to_nodeset(hwloc->topo, curbind, nodeset);
+    if (QUO_SUCCESS != (rc = bind_stack_push(bs, nodeset, flags))) goto out;
+    /* same as what is already in effect? then skip the system call. */
+    if (bs->top > 2 && bs->flags[bs->top - 2] == flags &&
+        quo_internal_hwloc_bitmap_isequal(bs->bind_stack[bs->top - 2],
+                                          nodeset)) {
+        goto out;
+    }
+    if (QUO_SUCCESS != (rc = membind_apply(hwloc, bs->top - 1,
+                                           flags & QUO_MEMBIND_MIGRATE))) {
+        /* the process policy and some of the buffers may have moved already.
+         * put them back where the previous entry has them, so that the stack
+         * still describes what is in effect, but keep the failed push's
+         * migration statistics. */
+        const size_t nbytes = hwloc->migrate_nbytes;
+        const double secs = hwloc->migrate_secs;
+        (void)membind_apply(hwloc, bs->top - 2, flags & QUO_MEMBIND_MIGRATE);
+        hwloc->migrate_nbytes = nbytes;
+        hwloc->migrate_secs = secs;
+        (void)bind_stack_pop(bs, NULL);
+        goto out;
+    }
+out:
+    if (tofree) quo_internal_hwloc_bitmap_free(tofree);
+    quo_internal_hwloc_bitmap_free(nodeset);
+    return rc;
+}
 
-    cpu_per_thread = (double)count / (num_omp_threads * qids_in_type);
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+quo_hwloc_membind_pop(quo_hwloc_t *hwloc)
+{
+    int rc = QUO_SUCCESS;
+    bind_stack_t *bs = NULL;
 
-    min = (num_omp_threads * qid + omp_thread) * cpu_per_thread;
-    max = min + cpu_per_thread;
+    if (!hwloc) return QUO_ERR_INVLD_ARG;
+    bs = &hwloc->mbstack;
+    /* the bottom entry is ours, not the caller's */
+    if (bs->top <= 1) return QUO_ERR_POP;
+    if (QUO_SUCCESS != (rc = bind_stack_pop(bs, NULL))) return rc;
+    /* the popped entry is still in the pool right above the new top */
+    const int i = bs->top - 1;
+    if (i > 0 && bs->flags[i] == bs->flags[i + 1] &&
+        quo_internal_hwloc_bitmap_isequal(bs->bind_stack[i],
+                                          bs->bind_stack[i + 1])) {
+        return QUO_SUCCESS;
+    }
+    /* undo a migrating push by migrating back */
+    return membind_apply(hwloc, i, bs->flags[i + 1] & QUO_MEMBIND_MIGRATE);
+}
 
-    if (cpu_per_thread < 1)
-        min = (int)min;
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+quo_hwloc_membind_register(quo_hwloc_t *hwloc,
+                           const void *buf,
+                           size_t nbytes)
+{
+    if (!hwloc || !buf) return QUO_ERR_INVLD_ARG;
 
-    for (i = 0; i < min; i++) {
-        cpu = hwloc_bitmap_first(set);
-        hwloc_bitmap_clr(set, cpu);
+    if (hwloc->nmembufs == hwloc->membufs_size) {
+        const int new_size = hwloc->membufs_size ? 2 * hwloc->membufs_size : 8;
+        membuf_t *tmp = realloc(hwloc->membufs, new_size * sizeof(*tmp));
+        if (!tmp) {
+            QUO_OOR_COMPLAIN();
+            return QUO_ERR_OOR;
+        }
+        hwloc->membufs = tmp;
+        hwloc->membufs_size = new_size;
     }
+    hwloc->membufs[hwloc->nmembufs].addr = buf;
+    hwloc->membufs[hwloc->nmembufs].len = nbytes;
+    hwloc->nmembufs++;
+    return QUO_SUCCESS;
+}
 
-    CPU_ZERO(&new_set);
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+quo_hwloc_membind_unregister(quo_hwloc_t *hwloc,
+                             const void *buf)
+{
+    if (!hwloc || !buf) return QUO_ERR_INVLD_ARG;
 
-    for (; i < max && i < count; i++) {
-        cpu = hwloc_bitmap_first(set);
-        CPU_SET(cpu, &new_set);
-        hwloc_bitmap_clr(set, cpu);
+    for (int b = 0; b < hwloc->nmembufs; ++b) {
+        if (buf != hwloc->membufs[b].addr) continue;
+        hwloc->membufs[b] = hwloc->membufs[--hwloc->nmembufs];
+        return QUO_SUCCESS;
     }
+    return QUO_ERR_NOT_FOUND;
+}
 
-    if(QUO_SUCCESS != (rc = sched_setaffinity(syscall(SYS_gettid),
-                                              sizeof(cpu_set_t), &new_set)))
-        return rc;
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+quo_hwloc_membind_migrate_stats(const quo_hwloc_t *hwloc,
+                                size_t *out_nbytes,
+                                double *out_seconds)
+{
+    if (!hwloc || !out_nbytes || !out_seconds) return QUO_ERR_INVLD_ARG;
 
-    hwloc_bitmap_free(set);
+    *out_nbytes = hwloc->migrate_nbytes;
+    *out_seconds = hwloc->migrate_secs;
+    return QUO_SUCCESS;
+}
 
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+quo_hwloc_bind_epoch(const quo_hwloc_t *hwloc,
+                     unsigned long *out_epoch)
+{
+    if (!hwloc || !out_epoch) return QUO_ERR_INVLD_ARG;
+    *out_epoch = hwloc->bind_epoch;
     return QUO_SUCCESS;
-#endif
 }
 
 /* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Returns the logical index of the object of the given type whose cpuset
+ * includes the caller's current binding, or -1 if no such object exists (e.g.,
+ * the caller is bound across sockets).
+ */
 int
-quo_hwloc_bind_nested_threads(quo_hwloc_t *hwloc,
-                              int omp_thread,
-                              int num_omp_threads)
+quo_hwloc_get_enclosing_obj_index(const quo_hwloc_t *hwloc,
+                                  QUO_obj_type_t type,
+                                  int *out_index)
 {
-    // TODO FIXME
-#if 1
-    QUO_UNUSED(hwloc);
-    QUO_UNUSED(omp_thread);
-    QUO_UNUSED(num_omp_threads);
-    return QUO_ERR_NOT_SUPPORTED;
-#else
-    cpu_set_t set, new_set;
-    int total, count = 0;
-    double cpu_per_thread;
-    unsigned i, x, y;
-    int rc = QUO_ERR;
+    int rc = QUO_SUCCESS, nobjs = 0;
+    quo_internal_hwloc_const_cpuset_t cur_bind = NULL;
+    quo_internal_hwloc_cpuset_t tofree = NULL;
+    quo_internal_hwloc_obj_t obj = NULL;
 
-    if(QUO_SUCCESS !=
-       (rc = sched_getaffinity(syscall(SYS_gettid), sizeof(cpu_set_t), &set)))
+    if (!hwloc || !out_index) return QUO_ERR_INVLD_ARG;
+    *out_index = -1;
+    if (QUO_SUCCESS != (rc = quo_hwloc_get_nobjs_by_type(hwloc, type,
+                                                         &nobjs))) {
         return rc;
-
-    if(QUO_SUCCESS !=
-       (rc = quo_hwloc_get_nobjs_by_type(hwloc, QUO_OBJ_PU, &total)))
+    }
+    if (QUO_SUCCESS != (rc = get_cur_bind_ref(hwloc, hwloc->mypid,
+                                              &cur_bind, &tofree))) {
         return rc;
+    }
+    for (int i = 0; i < nobjs; ++i) {
+        if (QUO_SUCCESS != (rc = get_obj_by_type(hwloc, type, i, &obj))) {
+            goto out;
+        }
+        if (quo_internal_hwloc_bitmap_isincluded(cur_bind, obj->cpuset)) {
+            *out_index = i;
+            break;
+        }
+    }
+out:
+    if (tofree) quo_internal_hwloc_bitmap_free(tofree);
+    return rc;
+}
 
-    count = CPU_COUNT(&set);
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+quo_hwloc_set_smt_policy(quo_hwloc_t *hwloc,
+                         QUO_smt_policy_t policy)
+{
+    if (!hwloc) return QUO_ERR_INVLD_ARG;
 
-    cpu_per_thread = (double)count / num_omp_threads;
+    switch (policy) {
+        case QUO_SMT_CORES_FIRST:
+        case QUO_SMT_ONE_PU_PER_CORE:
+        case QUO_SMT_SIBLINGS:
+            hwloc->smt_policy = policy;
+            return QUO_SUCCESS;
+        default:
+            QUO_ERR_MSG("invalid SMT policy");
+            return QUO_ERR_INVLD_ARG;
+    }
+}
 
-    i = 0;
-    x = 0;
-    y = 0;
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Binds the calling thread to the PU of cpuset that the SMT policy gives to
+ * slot slot of nslots.
+ */
+static int
+bind_thread_slot(quo_hwloc_t *hwloc,
+                 quo_internal_hwloc_const_cpuset_t cpuset,
+                 int slot,
+                 int nslots)
+{
+    int rc = QUO_SUCCESS, ncores = 0, core = 0, rank = 0, pu = 0;
+    int *core_offs = NULL, *pus = NULL;
+    quo_internal_hwloc_cpuset_t target = NULL;
 
-    CPU_ZERO(&new_set);
+    if (slot < 0 || nslots <= 0 || slot >= nslots) return QUO_ERR_INVLD_ARG;
 
-    while (i < total)  {
-        if (CPU_ISSET(i, &set)) {
-            if (x < ((double)cpu_per_thread *
-                     omp_thread) && cpu_per_thread >= 1) {
-                x++;
-            }
-            else if (y < cpu_per_thread) {
-                CPU_SET(i , &new_set);
-                y++;
-                if (y == cpu_per_thread)
-                    break;
-            }
+    if (QUO_SUCCESS != (rc = smt_layout(hwloc, cpuset, &ncores,
+                                        &core_offs, &pus))) {
+        return rc;
+    }
+    /* one PU per core leaves no room for a second thread on a core */
+    if (QUO_SMT_ONE_PU_PER_CORE == hwloc->smt_policy && nslots > ncores) {
+        QUO_ERR_MSG("more threads than cores with QUO_SMT_ONE_PU_PER_CORE");
+        rc = QUO_ERR_INVLD_ARG;
+        goto out;
+    }
+    if (QUO_SMT_SIBLINGS == hwloc->smt_policy) {
+        /* fill a core's PUs before moving on to the next core */
+        pu = pus[slot % core_offs[ncores]];
+    }
+    else {
+        /* spread over the cores, then (if allowed) over their siblings */
+        if (nslots <= ncores) {
+            core = (int)(((long)slot * ncores) / nslots);
+        }
+        else {
+            core = slot % ncores;
+            rank = slot / ncores;
         }
-        i++;
+        pu = pus[core_offs[core] +
+                 rank % (core_offs[core + 1] - core_offs[core])];
+    }
+    if (NULL == (target = quo_internal_hwloc_bitmap_alloc())) {
+        QUO_OOR_COMPLAIN();
+        rc = QUO_ERR_OOR;
+        goto out;
+    }
+    quo_internal_hwloc_bitmap_only(target, pu);
+    if (-1 == quo_internal_hwloc_set_cpubind(hwloc->topo, target,
+                                             HWLOC_CPUBIND_THREAD)) {
+        rc = QUO_ERR_NOT_SUPPORTED;
     }
+    else QUO_ATOMIC_STORE_RLX(&hwloc->thread_bound, true);
+out:
+    free(core_offs);
+    free(pus);
+    if (target) quo_internal_hwloc_bitmap_free(target);
+    return rc;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+quo_hwloc_bind_thread(quo_hwloc_t *hwloc,
+                      int tid,
+                      int nthreads)
+{
+    int rc = QUO_SUCCESS;
+    quo_internal_hwloc_const_cpuset_t curbind = NULL;
+    quo_internal_hwloc_cpuset_t tofree = NULL;
 
-    if(QUO_SUCCESS != (rc = sched_setaffinity(syscall(SYS_gettid),
-                               sizeof(cpu_set_t), &new_set)))
+    if (!hwloc) return QUO_ERR_INVLD_ARG;
+
+    if (QUO_SUCCESS != (rc = get_cur_bind_ref(hwloc, hwloc->mypid,
+                                              &curbind, &tofree))) {
         return rc;
+    }
+    rc = bind_thread_slot(hwloc, curbind, tid, nthreads);
+    if (tofree) quo_internal_hwloc_bitmap_free(tofree);
+    return rc;
+}
 
-    return QUO_SUCCESS;
-#endif
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+quo_hwloc_bind_threads(quo_hwloc_t *hwloc,
+                       int qid,
+                       int qids_in_type,
+                       int omp_thread,
+                       int num_omp_threads)
+{
+    int rc = QUO_SUCCESS;
+    quo_internal_hwloc_const_cpuset_t curbind = NULL;
+    quo_internal_hwloc_cpuset_t tofree = NULL;
+
+    if (!hwloc) return QUO_ERR_INVLD_ARG;
+
+    if (QUO_SUCCESS != (rc = get_cur_bind_ref(hwloc, hwloc->mypid,
+                                              &curbind, &tofree))) {
+        return rc;
+    }
+    /* the qids_in_type processes share our binding: hand out slots by qid */
+    rc = bind_thread_slot(hwloc, curbind,
+                          qid * num_omp_threads + omp_thread,
+                          qids_in_type * num_omp_threads);
+    if (tofree) quo_internal_hwloc_bitmap_free(tofree);
+    return rc;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+quo_hwloc_bind_nested_threads(quo_hwloc_t *hwloc,
+                              int omp_thread,
+                              int num_omp_threads)
+{
+    int rc = QUO_SUCCESS;
+    quo_internal_hwloc_cpuset_t thread_bind = NULL;
+
+    if (!hwloc) return QUO_ERR_INVLD_ARG;
+
+    if (NULL == (thread_bind = quo_internal_hwloc_bitmap_alloc())) {
+        QUO_OOR_COMPLAIN();
+        return QUO_ERR_OOR;
+    }
+    /* split the binding that we inherited from our parent thread */
+    if (-1 == quo_internal_hwloc_get_cpubind(hwloc->topo, thread_bind,
+                                             HWLOC_CPUBIND_THREAD)) {
+        rc = QUO_ERR_NOT_SUPPORTED;
+        goto out;
+    }
+    rc = bind_thread_slot(hwloc, thread_bind, omp_thread, num_omp_threads);
+out:
+    quo_internal_hwloc_bitmap_free(thread_bind);
+    return rc;
 }
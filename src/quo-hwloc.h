@@ -88,6 +88,13 @@ quo_hwloc_get_nobjs_in_type_by_type(const quo_hwloc_t *hwloc,
                                     QUO_obj_type_t type,
                                     int *out_result);
 
+int
+quo_hwloc_get_first_obj_in_type_by_type(const quo_hwloc_t *hwloc,
+                                        QUO_obj_type_t in_type,
+                                        unsigned in_type_index,
+                                        QUO_obj_type_t type,
+                                        int *out_index);
+
 int
 quo_hwloc_is_in_cpuset_by_type_id(const quo_hwloc_t *hwloc,
                                   QUO_obj_type_t type,
@@ -95,6 +102,38 @@ quo_hwloc_is_in_cpuset_by_type_id(const quo_hwloc_t *hwloc,
                                   unsigned type_index,
                                   int *out_result);
 
+int
+quo_hwloc_qids_in_type(const quo_hwloc_t *hwloc,
+                       QUO_obj_type_t type,
+                       unsigned type_index,
+                       int *out_nqids,
+                       int *out_qids);
+
+int
+quo_hwloc_qids_in_type_mask(const quo_hwloc_t *hwloc,
+                            QUO_obj_type_t type,
+                            unsigned type_index,
+                            uint64_t *out_mask,
+                            unsigned nwords);
+
+int
+quo_hwloc_qid_overlap(const quo_hwloc_t *hwloc,
+                      int qid,
+                      QUO_obj_type_t type,
+                      unsigned type_index,
+                      int *out_noverlap,
+                      int *out_nbound);
+
+int
+quo_hwloc_bind_digest(const quo_hwloc_t *hwloc,
+                      uint64_t *out_digest);
+
+int
+quo_hwloc_get_cur_bind_words(const quo_hwloc_t *hwloc,
+                             pid_t pid,
+                             uint64_t *words,
+                             unsigned nwords);
+
 int
 quo_hwloc_bound(const quo_hwloc_t *hwloc,
                 pid_t pid,
@@ -116,9 +155,58 @@ quo_hwloc_bind_push(quo_hwloc_t *hwloc,
                     QUO_obj_type_t type,
                     unsigned obj_index);
 
+int
+quo_hwloc_bind_push_cpuset(quo_hwloc_t *hwloc,
+                           const char *cpuset_str);
+
+int
+quo_hwloc_bind_push_objs(quo_hwloc_t *hwloc,
+                         const QUO_obj_type_t *types,
+                         const int *obj_indices,
+                         int nobjs);
+
 int
 quo_hwloc_bind_pop(quo_hwloc_t *hwloc);
 
+int
+quo_hwloc_membind_push(quo_hwloc_t *hwloc,
+                       int flags);
+
+int
+quo_hwloc_membind_pop(quo_hwloc_t *hwloc);
+
+int
+quo_hwloc_membind_register(quo_hwloc_t *hwloc,
+                           const void *buf,
+                           size_t nbytes);
+
+int
+quo_hwloc_membind_unregister(quo_hwloc_t *hwloc,
+                             const void *buf);
+
+int
+quo_hwloc_membind_migrate_stats(const quo_hwloc_t *hwloc,
+                                size_t *out_nbytes,
+                                double *out_seconds);
+
+int
+quo_hwloc_bind_epoch(const quo_hwloc_t *hwloc,
+                     unsigned long *out_epoch);
+
+int
+quo_hwloc_get_enclosing_obj_index(const quo_hwloc_t *hwloc,
+                                  QUO_obj_type_t type,
+                                  int *out_index);
+
+int
+quo_hwloc_set_smt_policy(quo_hwloc_t *hwloc,
+                         QUO_smt_policy_t policy);
+
+int
+quo_hwloc_bind_thread(quo_hwloc_t *hwloc,
+                      int tid,
+                      int nthreads);
+
 int
 quo_hwloc_bind_threads(quo_hwloc_t *hwloc,
 		       int qid,
@@ -95,6 +95,12 @@
 #ifdef HAVE_TIME_H
 #include <time.h>
 #endif
+#ifdef HAVE_STDINT_H
+#include <stdint.h>
+#endif
+#ifdef HAVE_SCHED_H
+#include <sched.h>
+#endif
 
 #include "mpi.h"
 
@@ -103,13 +109,86 @@
  * about checking if everything has been setup before continuing with the
  * operation. */
 
-/** Pthread-based inter-process quiescence structure that is embedded in a
- * shared-memory segment (one per node per context). */
+/** Assumed cache line size (in B). Keeps shared flags on their own lines. */
+#define QUO_MPI_CACHE_LINE_SIZE 64
+/** Number of pipeline slots in the node broadcast staging area. */
+#define QUO_MPI_SM_BCAST_NSLOTS 4
+/** Size (in B) of a single node broadcast pipeline slot. */
+#define QUO_MPI_SM_BCAST_SLOT_SIZE (64 * 1024)
+/** Size (in B) of each half of the double-buffered node collective scratch. */
+#define QUO_MPI_SM_SCRATCH_SIZE (512 * 1024)
+/** Number of busy-wait iterations before a waiter starts yielding its core. */
+#define QUO_MPI_SM_SPIN_MAX 1024
+
+/** Control block for a node broadcast pipeline slot. */
+typedef struct quo_sm_bcast_slot_t {
+    /** One plus the broadcast round last published into this slot. */
+    uint64_t seq;
+    /** Number of readers done with the slot's current payload. */
+    int nread;
+} __attribute__((aligned(QUO_MPI_CACHE_LINE_SIZE))) quo_sm_bcast_slot_t;
+
+/** Pthread-based inter-process quiescence structure and node-local collective
+ * staging areas that are embedded in a shared-memory segment (one per node per
+ * context). */
 typedef struct quo_shmem_barrier_segment_t {
     /** The barrier structure. */
     pthread_barrier_t barrier;
+    /** Node broadcast slot control blocks. */
+    quo_sm_bcast_slot_t bcast_slots[QUO_MPI_SM_BCAST_NSLOTS];
+    /** Node broadcast staging area. */
+    char bcast_data[QUO_MPI_SM_BCAST_NSLOTS][QUO_MPI_SM_BCAST_SLOT_SIZE];
+    /** Node reduction and allgather scratch (double-buffered). */
+    char scratch[2][QUO_MPI_SM_SCRATCH_SIZE]
+        __attribute__((aligned(QUO_MPI_CACHE_LINE_SIZE)));
 } quo_shmem_barrier_segment_t;
 
+/** Element-wise reduction kernel: acc[i] = acc[i] op in[i] for i < n. */
+typedef void (*quo_sm_reduce_fn_t)(void *restrict acc,
+                                   const void *restrict in,
+                                   size_t n);
+
+/** Number of elements processed per fixed-length block in reduction kernels. */
+#define QUO_SM_REDUCE_BLOCK 16
+
+/**
+ * Generates a reduction kernel. The bulk of the work is done in fixed-length,
+ * restrict-qualified blocks that the compiler vectorizes even under its cheapest
+ * cost model (i.e., at -O2); the tail is handled one element at a time.
+ */
+#define QUO_SM_REDUCE_KERNEL(name, type, expr)                                 \
+static void                                                                    \
+name(void *restrict accv,                                                      \
+     const void *restrict inv,                                                 \
+     size_t n)                                                                 \
+{                                                                              \
+    type *restrict acc = (type *)accv;                                         \
+    const type *restrict in = (const type *)inv;                               \
+    size_t i = 0;                                                              \
+    for (; i + QUO_SM_REDUCE_BLOCK <= n; i += QUO_SM_REDUCE_BLOCK) {           \
+        type *restrict bacc = acc + i;                                         \
+        const type *restrict bin = in + i;                                     \
+        for (size_t j = 0; j < QUO_SM_REDUCE_BLOCK; ++j) {                     \
+            const type a = bacc[j], b = bin[j];                                \
+            bacc[j] = (expr);                                                  \
+        }                                                                      \
+    }                                                                          \
+    for (; i < n; ++i) {                                                       \
+        const type a = acc[i], b = in[i];                                      \
+        acc[i] = (expr);                                                       \
+    }                                                                          \
+}
+
+QUO_SM_REDUCE_KERNEL(sm_reduce_sum_int,    int,    a + b)
+QUO_SM_REDUCE_KERNEL(sm_reduce_min_int,    int,    b < a ? b : a)
+QUO_SM_REDUCE_KERNEL(sm_reduce_max_int,    int,    b > a ? b : a)
+QUO_SM_REDUCE_KERNEL(sm_reduce_sum_float,  float,  a + b)
+QUO_SM_REDUCE_KERNEL(sm_reduce_min_float,  float,  b < a ? b : a)
+QUO_SM_REDUCE_KERNEL(sm_reduce_max_float,  float,  b > a ? b : a)
+QUO_SM_REDUCE_KERNEL(sm_reduce_sum_double, double, a + b)
+QUO_SM_REDUCE_KERNEL(sm_reduce_min_double, double, b < a ? b : a)
+QUO_SM_REDUCE_KERNEL(sm_reduce_max_double, double, b > a ? b : a)
+
 /**
  * Maintains pid to smprank mapping.
  */
@@ -120,6 +199,18 @@ typedef struct pid_smprank_map_t {
     int smprank;
 } pid_smprank_map_t;
 
+/**
+ * A cached, binding-dependent communicator.
+ */
+typedef struct quo_cached_comm_t {
+    /** Whether or not the communicator has been created. */
+    bool created;
+    /** Binding epoch the communicator was created for. */
+    unsigned long epoch;
+    /** The communicator (MPI_COMM_NULL if I am not a member). */
+    MPI_Comm comm;
+} quo_cached_comm_t;
+
 /* ////////////////////////////////////////////////////////////////////////// */
 struct quo_mpi_t {
     /** Whether or not MPI is initialized. */
@@ -153,6 +244,20 @@ struct quo_mpi_t {
     quo_shmem_barrier_segment_t *bsegp;
     /** Shared memory instance for node-local barrier. */
     quo_sm_t *barrier_sm;
+    /** Number of node broadcast rounds (slot fills) I have taken part in. */
+    uint64_t bcast_round;
+    /** Number of scratch rounds (reduction or allgather) I have taken part in.
+     * Its parity selects the half of the scratch area that is used next. */
+    uint64_t scratch_round;
+    /** Leader communicators, indexed by object type. */
+    quo_cached_comm_t leader_comms[QUO_OBJ_NTYPES];
+    /** Node-local object communicators, indexed by object type. */
+    quo_cached_comm_t type_comms[QUO_OBJ_NTYPES];
+    /** Leader communicators that have been replaced, but may still be in use
+     * by the caller. Freed at destruct time. */
+    MPI_Comm *retired_comms;
+    /** Number of retired communicators. */
+    int nretired_comms;
 };
 
 /* ////////////////////////////////////////////////////////////////////////// */
@@ -315,48 +420,24 @@ pid_smprank_xchange(quo_mpi_t *mpi)
 {
     int rc = QUO_SUCCESS;
     pid_smprank_map_t my_info;
+
+    if (!mpi) return QUO_ERR_INVLD_ARG;
+    memset(&my_info, 0, sizeof(my_info));
     my_info.pid = (long)getpid();
     my_info.smprank = mpi->smprank;
 
-    if (!mpi) return QUO_ERR_INVLD_ARG;
     if (NULL == (mpi->pid_smprank_map = calloc(mpi->nsmpranks,
                                                sizeof(pid_smprank_map_t)))) {
         QUO_OOR_COMPLAIN();
         return QUO_ERR_OOR;
     }
-    /* ////////////////////////////////////////////////////////////////////// */
-    /* if you update pid_smprank_map, then update this code                   */
-    /* ////////////////////////////////////////////////////////////////////// */
-    /* number of items in the struct */
-    int nitems = 2;
-    int block_lens[2] = {1, 1};
-    /* array of base mpi types that the struct is made up of */
-    MPI_Datatype types[2] = {MPI_LONG, MPI_INT};
-    /* the mpi datatype that we are creating */
-    MPI_Datatype pid_smprank_type;
-    /* type offsets */
-    MPI_Aint offsets[2];
-    offsets[0] = offsetof(pid_smprank_map_t, pid);
-    offsets[1] = offsetof(pid_smprank_map_t, smprank);
-    /* create the thing */
-    if (MPI_SUCCESS != MPI_Type_create_struct(nitems,
-                                              block_lens,
-                                              offsets,
-                                              types,
-                                              &pid_smprank_type)) {
-        rc = QUO_ERR_MPI;
-        goto out;
-    }
-    if (MPI_SUCCESS != MPI_Type_commit(&pid_smprank_type)) {
-        rc = QUO_ERR_MPI;
+    /* now exchange the data between all ranks on the node (via shared memory).
+     * the map entries are plain old data, so no need for an mpi type here. */
+    if (QUO_SUCCESS != (rc = quo_mpi_sm_allgather(mpi, &my_info,
+                                                  sizeof(my_info),
+                                                  mpi->pid_smprank_map))) {
         goto out;
     }
-    /* now exchange the data between all ranks on the node (via smpcomm) */
-    if (MPI_SUCCESS != MPI_Allgather(&my_info, 1, pid_smprank_type,
-                                     mpi->pid_smprank_map, 1, pid_smprank_type,
-                                     mpi->smpcomm)) {
-        return QUO_ERR_MPI;
-    }
 out:
     /* error path */
     if (QUO_SUCCESS != rc) {
@@ -365,8 +446,6 @@ out:
             mpi->pid_smprank_map = NULL;
         }
     }
-    /* no longer needed */
-    if (MPI_SUCCESS != MPI_Type_free(&pid_smprank_type)) rc = QUO_ERR_MPI;
     return rc;
 }
 
@@ -379,10 +458,9 @@ node_rank_xchange(quo_mpi_t *mpi)
     if (!mpi) return QUO_ERR_INVLD_ARG;
     mpi->node_ranks = calloc(mpi->nsmpranks, sizeof(int));
     if (!mpi->node_ranks) return QUO_ERR_OOR;
-    if (MPI_SUCCESS != MPI_Allgather(&(mpi->rank), 1, MPI_INT,
-                                     mpi->node_ranks, 1, MPI_INT,
-                                     mpi->smpcomm)) {
-        rc = QUO_ERR_MPI;
+    if (QUO_SUCCESS != (rc = quo_mpi_sm_allgather(mpi, &(mpi->rank),
+                                                  sizeof(int),
+                                                  mpi->node_ranks))) {
         goto out;
     }
 out:
@@ -459,6 +537,71 @@ out:
     return rc;
 }
 
+/* ////////////////////////////////////////////////////////////////////////// */
+/** Initializes the node-local collective state in a fresh barrier segment. */
+static void
+sm_coll_init(quo_mpi_t *mpi)
+{
+    /* every slot starts out as if all readers are done with it */
+    for (int i = 0; i < QUO_MPI_SM_BCAST_NSLOTS; ++i) {
+        mpi->bsegp->bcast_slots[i].seq = 0;
+        mpi->bsegp->bcast_slots[i].nread = mpi->nsmpranks - 1;
+    }
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/** Backoff used while spinning on a shared-memory flag. */
+static inline void
+sm_spin_relax(unsigned *nspins)
+{
+    /* we may be sharing cores with the process that we are waiting on */
+    if (*nspins < QUO_MPI_SM_SPIN_MAX) ++(*nspins);
+    else sched_yield();
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Returns the reduction kernel (and element size) for the provided
+ * type/operation pair, or NULL if the pair is not supported.
+ */
+static quo_sm_reduce_fn_t
+sm_reduce_fn(MPI_Datatype datatype,
+             MPI_Op op,
+             size_t *out_elem_size)
+{
+    if (MPI_INT == datatype) {
+        *out_elem_size = sizeof(int);
+        if (MPI_SUM == op) return sm_reduce_sum_int;
+        if (MPI_MIN == op) return sm_reduce_min_int;
+        if (MPI_MAX == op) return sm_reduce_max_int;
+    }
+    else if (MPI_FLOAT == datatype) {
+        *out_elem_size = sizeof(float);
+        if (MPI_SUM == op) return sm_reduce_sum_float;
+        if (MPI_MIN == op) return sm_reduce_min_float;
+        if (MPI_MAX == op) return sm_reduce_max_float;
+    }
+    else if (MPI_DOUBLE == datatype) {
+        *out_elem_size = sizeof(double);
+        if (MPI_SUM == op) return sm_reduce_sum_double;
+        if (MPI_MIN == op) return sm_reduce_min_double;
+        if (MPI_MAX == op) return sm_reduce_max_double;
+    }
+    return NULL;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Returns the size (in B) of a process's slot in either half of the scratch
+ * area. Slots are kept a multiple of the cache line size.
+ */
+static size_t
+sm_scratch_slot_size(const quo_mpi_t *mpi)
+{
+    return (QUO_MPI_SM_SCRATCH_SIZE / (size_t)mpi->nsmpranks) &
+           ~((size_t)QUO_MPI_CACHE_LINE_SIZE - 1);
+}
+
 /* ////////////////////////////////////////////////////////////////////////// */
 static int
 bseg_create(quo_mpi_t *mpi)
@@ -478,6 +621,8 @@ bseg_create(quo_mpi_t *mpi)
     mpi->bsegp = quo_sm_get_basep(mpi->barrier_sm);
     /*setup mutex, condition, and barrier counter */
     if (QUO_SUCCESS != (rc = ptmc_init(mpi))) goto out;
+    /* setup node-local collective state */
+    sm_coll_init(mpi);
 out:
     if (badfunc) {
         fprintf(stderr, QUO_ERR_PREFIX"%s failure: rc=%d\n", badfunc, rc);
@@ -610,9 +755,8 @@ quo_mpi_smprank2pid(quo_mpi_t *mpi,
 {
     if (!mpi || !out_pid) return QUO_ERR_INVLD_ARG;
 
-    /* MPI_Allgather guarantees rank ordering. Since we used the SMP
-     * communicator for this exchange, the ith item will always correspond to
-     * the SMP rank i. */
+    /* quo_mpi_sm_allgather stores contributions in smprank order, so the ith
+     * item will always correspond to the SMP rank i. */
     *out_pid = (pid_t)mpi->pid_smprank_map[smprank].pid;
 
     return QUO_SUCCESS;
@@ -665,13 +809,13 @@ quo_mpi_init(quo_mpi_t *mpi,
     if (QUO_SUCCESS != (rc = init_setup(mpi, comm))) goto err;
     /* setup node rank info */
     if (QUO_SUCCESS != (rc = smprank_setup(mpi))) goto err;
+    /* now setup shared memory stuff for our barrier and node collectives */
+    if (QUO_SUCCESS != (rc = sm_setup(mpi))) goto err;
     /* mpi is setup and we know about our node neighbors and all the jive, so
      * setup and exchange node pids and node ranks. */
     if (QUO_SUCCESS != (rc = pid_smprank_xchange(mpi))) goto err;
     /* now cache the initializing comm ranks that are the node with me */
     if (QUO_SUCCESS != (rc = node_rank_xchange(mpi))) goto err;
-    /* now setup shared memory stuff for our barrier */
-    if (QUO_SUCCESS != (rc = sm_setup(mpi))) goto err;
     return QUO_SUCCESS;
 err:
     quo_mpi_destruct(mpi);
@@ -686,9 +830,26 @@ quo_mpi_destruct(quo_mpi_t *mpi)
 
     if (!mpi) return QUO_ERR_INVLD_ARG;
     if (mpi->mpi_inited) {
+        for (int i = 0; i < QUO_OBJ_NTYPES; ++i) {
+            quo_cached_comm_t *lc = &(mpi->leader_comms[i]);
+            quo_cached_comm_t *tc = &(mpi->type_comms[i]);
+            if (lc->created && MPI_COMM_NULL != lc->comm) {
+                if (MPI_SUCCESS != MPI_Comm_free(&(lc->comm))) nerrs++;
+            }
+            if (tc->created && MPI_COMM_NULL != tc->comm) {
+                if (MPI_SUCCESS != MPI_Comm_free(&(tc->comm))) nerrs++;
+            }
+        }
+        for (int i = 0; i < mpi->nretired_comms; ++i) {
+            if (MPI_SUCCESS != MPI_Comm_free(&(mpi->retired_comms[i]))) nerrs++;
+        }
         if (MPI_SUCCESS != MPI_Comm_free(&(mpi->commchan))) nerrs++;
         if (MPI_SUCCESS != MPI_Comm_free(&(mpi->smpcomm))) nerrs++;
     }
+    if (mpi->retired_comms) {
+        free(mpi->retired_comms);
+        mpi->retired_comms = NULL;
+    }
     if (mpi->pid_smprank_map) {
         free(mpi->pid_smprank_map);
         mpi->pid_smprank_map = NULL;
@@ -769,28 +930,76 @@ quo_mpi_sm_barrier(const quo_mpi_t *mpi)
 }
 
 /* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Returns a dup of the communicator that contains all node-local ranks whose
+ * current binding lies within the same object of the given type as mine. The
+ * underlying communicators are cached per binding epoch.
+ *
+ * @param[in] mpi MPI instance.
+ *
+ * @param[in] target_type Object type.
+ *
+ * @param[in] my_obj_index Index of the object of the given type that encloses
+ *                         my current binding, or -1 if there isn't one. Ignored
+ *                         for QUO_OBJ_MACHINE.
+ *
+ * @param[in] epoch My current binding epoch. Ignored for QUO_OBJ_MACHINE.
+ *
+ * @param[out] out_comm Dup of the cached communicator (MPI_COMM_NULL if my
+ *                      binding doesn't lie within a single such object).
+ */
 int
-quo_mpi_get_comm_by_type(const quo_mpi_t *mpi,
+quo_mpi_get_comm_by_type(quo_mpi_t *mpi,
                          QUO_obj_type_t target_type,
+                         int my_obj_index,
+                         unsigned long epoch,
                          MPI_Comm *out_comm)
 {
+    int rc = QUO_SUCCESS;
+
     if (!mpi || !out_comm) return QUO_ERR_INVLD_ARG;
+    if (target_type < QUO_OBJ_MACHINE || target_type >= QUO_OBJ_NTYPES) {
+        return QUO_ERR_INVLD_ARG;
+    }
 
-    switch (target_type) {
-        case QUO_OBJ_MACHINE:
-        {
-            /* this case is easy. just return a dup of the smp communicator that
-             * we already maintain internally. */
-            if (MPI_SUCCESS != MPI_Comm_dup(mpi->smpcomm, out_comm)) {
-                return QUO_ERR_MPI;
-            }
-            break;
+    *out_comm = MPI_COMM_NULL;
+    if (QUO_OBJ_MACHINE == target_type) {
+        /* this case is easy. just return a dup of the smp communicator that
+         * we already maintain internally. */
+        if (MPI_SUCCESS != MPI_Comm_dup(mpi->smpcomm, out_comm)) {
+            return QUO_ERR_MPI;
         }
-        /* TODO add support for other obj types */
-        default:
-            return QUO_ERR_NOT_SUPPORTED;
+        return QUO_SUCCESS;
     }
 
+    quo_cached_comm_t *tc = &(mpi->type_comms[target_type]);
+    /* everyone on the node has to agree on whether or not the cached
+     * communicator is still good, since the split is over smpcomm. */
+    int stale = (!tc->created || tc->epoch != epoch), any_stale = 0;
+    if (QUO_SUCCESS != (rc = quo_mpi_sm_allreduce(mpi, &stale, &any_stale, 1,
+                                                  MPI_INT, MPI_MAX))) {
+        return rc;
+    }
+    if (any_stale) {
+        /* we only ever hand out dups, so nobody else can be using this */
+        if (tc->created && MPI_COMM_NULL != tc->comm) {
+            if (MPI_SUCCESS != MPI_Comm_free(&(tc->comm))) return QUO_ERR_MPI;
+        }
+        tc->created = false;
+        const int color = (-1 == my_obj_index) ? MPI_UNDEFINED : my_obj_index;
+        if (MPI_SUCCESS != MPI_Comm_split(mpi->smpcomm, color, mpi->smprank,
+                                          &(tc->comm))) {
+            tc->comm = MPI_COMM_NULL;
+            return QUO_ERR_MPI;
+        }
+        tc->epoch = epoch;
+        tc->created = true;
+    }
+    if (MPI_COMM_NULL != tc->comm) {
+        if (MPI_SUCCESS != MPI_Comm_dup(tc->comm, out_comm)) {
+            return QUO_ERR_MPI;
+        }
+    }
     return QUO_SUCCESS;
 }
 
@@ -846,3 +1055,283 @@ quo_mpi_get_node_comm(quo_mpi_t *mpi,
 
     return QUO_SUCCESS;
 }
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Node-local broadcast through the barrier segment's staging area. The root
+ * copies the payload into the staging area one slot at a time and flips the
+ * slot's sequence flag; readers wait for the flip, copy out, and check in. Slots
+ * are used round-robin, so large payloads are pipelined: readers drain slot i
+ * while the root fills slot i + 1.
+ */
+int
+quo_mpi_sm_bcast(quo_mpi_t *mpi,
+                 void *buffer,
+                 size_t nbytes,
+                 int root)
+{
+    if (!mpi || (!buffer && 0 != nbytes)) return QUO_ERR_INVLD_ARG;
+    if (root < 0 || root >= mpi->nsmpranks) return QUO_ERR_INVLD_ARG;
+    /* nothing to do */
+    if (1 == mpi->nsmpranks || 0 == nbytes) return QUO_SUCCESS;
+
+    const int nreaders = mpi->nsmpranks - 1;
+    const bool i_am_root = (root == mpi->smprank);
+    char *bufp = (char *)buffer;
+
+    for (size_t off = 0; off < nbytes; off += QUO_MPI_SM_BCAST_SLOT_SIZE) {
+        size_t len = nbytes - off;
+        if (len > QUO_MPI_SM_BCAST_SLOT_SIZE) len = QUO_MPI_SM_BCAST_SLOT_SIZE;
+        const uint64_t round = mpi->bcast_round++;
+        const int sloti = (int)(round % QUO_MPI_SM_BCAST_NSLOTS);
+        quo_sm_bcast_slot_t *slot = &(mpi->bsegp->bcast_slots[sloti]);
+        char *slot_data = mpi->bsegp->bcast_data[sloti];
+        unsigned nspins = 0;
+
+        if (i_am_root) {
+            /* wait for the readers of the slot's previous payload */
+            while (nreaders != QUO_ATOMIC_LOAD_ACQ(&slot->nread)) {
+                sm_spin_relax(&nspins);
+            }
+            QUO_ATOMIC_STORE_REL(&slot->nread, 0);
+            (void)memcpy(slot_data, bufp + off, len);
+            /* publish */
+            QUO_ATOMIC_STORE_REL(&slot->seq, round + 1);
+        }
+        else {
+            while (round + 1 != QUO_ATOMIC_LOAD_ACQ(&slot->seq)) {
+                sm_spin_relax(&nspins);
+            }
+            (void)memcpy(bufp + off, slot_data, len);
+            (void)QUO_ATOMIC_FETCH_ADD(&slot->nread, 1);
+        }
+    }
+    return QUO_SUCCESS;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Node-local allreduce through the barrier segment's reduction scratch. The
+ * input is processed in pieces that fit in half of the scratch area. For each
+ * piece, every process deposits its contribution into its own slot; after a
+ * barrier, every process reduces a disjoint slice of the piece into slot 0;
+ * after another barrier, everyone copies the result out. Pieces alternate
+ * between the two halves of the scratch area, so the next piece's deposit can
+ * start without waiting for the previous piece's readers.
+ */
+int
+quo_mpi_sm_allreduce(quo_mpi_t *mpi,
+                     const void *sendbuf,
+                     void *recvbuf,
+                     int count,
+                     MPI_Datatype datatype,
+                     MPI_Op op)
+{
+    int rc = QUO_SUCCESS;
+    size_t esize = 0;
+    quo_sm_reduce_fn_t reduce = NULL;
+
+    if (!mpi || count < 0 || (0 != count && (!sendbuf || !recvbuf))) {
+        return QUO_ERR_INVLD_ARG;
+    }
+    if (NULL == (reduce = sm_reduce_fn(datatype, op, &esize))) {
+        return QUO_ERR_NOT_SUPPORTED;
+    }
+    if (MPI_IN_PLACE == sendbuf) sendbuf = recvbuf;
+    if (0 == count) return QUO_SUCCESS;
+    if (1 == mpi->nsmpranks) {
+        if (sendbuf != recvbuf) (void)memmove(recvbuf, sendbuf, count * esize);
+        return QUO_SUCCESS;
+    }
+
+    const size_t np = (size_t)mpi->nsmpranks, me = (size_t)mpi->smprank;
+    const size_t slot_size = sm_scratch_slot_size(mpi);
+    if (0 == slot_size) return QUO_ERR_NOT_SUPPORTED;
+    const size_t piece_max = slot_size / esize;
+    const char *sbufp = (const char *)sendbuf;
+    char *rbufp = (char *)recvbuf;
+
+    for (size_t first = 0; first < (size_t)count; first += piece_max) {
+        size_t n = (size_t)count - first;
+        if (n > piece_max) n = piece_max;
+        char *scratch = mpi->bsegp->scratch[mpi->scratch_round++ % 2];
+        /* deposit my contribution */
+        (void)memcpy(scratch + (me * slot_size), sbufp + (first * esize),
+                     n * esize);
+        if (QUO_SUCCESS != (rc = quo_mpi_sm_barrier(mpi))) return rc;
+        /* reduce my slice into slot 0 */
+        const size_t base = n / np, rem = n % np;
+        const size_t lo = me * base + (me < rem ? me : rem);
+        const size_t len = base + (me < rem ? 1 : 0);
+        if (0 != len) {
+            for (size_t r = 1; r < np; ++r) {
+                reduce(scratch + (lo * esize),
+                       scratch + (r * slot_size) + (lo * esize), len);
+            }
+        }
+        if (QUO_SUCCESS != (rc = quo_mpi_sm_barrier(mpi))) return rc;
+        /* everyone grabs the result */
+        (void)memcpy(rbufp + (first * esize), scratch, n * esize);
+    }
+    return QUO_SUCCESS;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Node-local allgather through the barrier segment's scratch area. Every
+ * process writes its contribution straight into its slot; a single barrier
+ * later, everyone copies out all the slots. Rounds alternate between the two
+ * halves of the scratch area, which is why one barrier per round suffices:
+ * nobody can start writing a half again before everyone has passed the barrier
+ * of the round in between (and is therefore done reading).
+ *
+ * recvbuf must be able to hold nbytes * nsmpranks bytes; contributions are
+ * stored in smprank order.
+ */
+int
+quo_mpi_sm_allgather(quo_mpi_t *mpi,
+                     const void *sendbuf,
+                     size_t nbytes,
+                     void *recvbuf)
+{
+    int rc = QUO_SUCCESS;
+
+    if (!mpi || (0 != nbytes && (!sendbuf || !recvbuf))) {
+        return QUO_ERR_INVLD_ARG;
+    }
+    if (0 == nbytes) return QUO_SUCCESS;
+
+    const size_t np = (size_t)mpi->nsmpranks, me = (size_t)mpi->smprank;
+    const size_t slot_size = sm_scratch_slot_size(mpi);
+    if (0 == slot_size) return QUO_ERR_NOT_SUPPORTED;
+    const char *sbufp = (const char *)sendbuf;
+    char *rbufp = (char *)recvbuf;
+
+    for (size_t off = 0; off < nbytes; off += slot_size) {
+        size_t len = nbytes - off;
+        if (len > slot_size) len = slot_size;
+        char *scratch = mpi->bsegp->scratch[mpi->scratch_round++ % 2];
+        (void)memcpy(scratch + (me * slot_size), sbufp + off, len);
+        if (QUO_SUCCESS != (rc = quo_mpi_sm_barrier(mpi))) return rc;
+        for (size_t r = 0; r < np; ++r) {
+            (void)memcpy(rbufp + (r * nbytes) + off,
+                         scratch + (r * slot_size), len);
+        }
+    }
+    return QUO_SUCCESS;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Stashes a leader communicator that is being replaced. The caller may still
+ * hold a handle to it, so it lives until destruct time.
+ */
+static int
+retire_comm(quo_mpi_t *mpi,
+            MPI_Comm comm)
+{
+    MPI_Comm *tmp = NULL;
+
+    if (MPI_COMM_NULL == comm) return QUO_SUCCESS;
+    tmp = realloc(mpi->retired_comms,
+                  (mpi->nretired_comms + 1) * sizeof(*tmp));
+    if (!tmp) {
+        QUO_OOR_COMPLAIN();
+        return QUO_ERR_OOR;
+    }
+    mpi->retired_comms = tmp;
+    mpi->retired_comms[mpi->nretired_comms++] = comm;
+    return QUO_SUCCESS;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Returns (creating it first, if needed) a communicator that contains one rank
+ * per object of the given type: the node rank 0 of every node for
+ * QUO_OBJ_MACHINE; for other types, the lowest node rank whose binding is
+ * enclosed by the object, for every such object on every node.
+ *
+ * @param[in] mpi MPI instance.
+ *
+ * @param[in] type Leader object type.
+ *
+ * @param[in] my_obj_index Index of the object of the given type that encloses
+ *                         my current binding, or -1 if there isn't one. Ignored
+ *                         for QUO_OBJ_MACHINE.
+ *
+ * @param[in] epoch My current binding epoch. Ignored for QUO_OBJ_MACHINE.
+ *
+ * @param[out] out_comm The cached leader communicator, MPI_COMM_NULL if I am
+ *                      not a leader.
+ */
+int
+quo_mpi_get_leader_comm(quo_mpi_t *mpi,
+                        QUO_obj_type_t type,
+                        int my_obj_index,
+                        unsigned long epoch,
+                        MPI_Comm *out_comm)
+{
+    int rc = QUO_SUCCESS, color = MPI_UNDEFINED;
+    int *obj_indices = NULL;
+
+    if (!mpi || !out_comm) return QUO_ERR_INVLD_ARG;
+    if (QUO_OBJ_MACHINE != type && QUO_OBJ_SOCKET != type) {
+        return QUO_ERR_NOT_SUPPORTED;
+    }
+
+    quo_cached_comm_t *lc = &(mpi->leader_comms[type]);
+
+    if (QUO_OBJ_MACHINE == type) {
+        /* node membership never changes, so this is built once */
+        if (lc->created) goto out;
+        color = (0 == mpi->smprank) ? 0 : MPI_UNDEFINED;
+    }
+    else {
+        /* leadership depends on bindings, so everyone has to agree on whether
+         * or not the cached communicator is still good. */
+        int stale = (!lc->created || lc->epoch != epoch), any_stale = 0;
+        if (MPI_SUCCESS != MPI_Allreduce(&stale, &any_stale, 1, MPI_INT,
+                                         MPI_LOR, mpi->commchan)) {
+            rc = QUO_ERR_MPI;
+            goto out;
+        }
+        if (!any_stale) goto out;
+        if (lc->created) {
+            if (QUO_SUCCESS != (rc = retire_comm(mpi, lc->comm))) goto out;
+            lc->created = false;
+            lc->comm = MPI_COMM_NULL;
+        }
+        if (NULL == (obj_indices = calloc(mpi->nsmpranks,
+                                          sizeof(*obj_indices)))) {
+            QUO_OOR_COMPLAIN();
+            rc = QUO_ERR_OOR;
+            goto out;
+        }
+        if (QUO_SUCCESS != (rc = quo_mpi_sm_allgather(mpi, &my_obj_index,
+                                                      sizeof(my_obj_index),
+                                                      obj_indices))) {
+            goto out;
+        }
+        /* i lead if nobody before me is in the same object */
+        if (-1 != my_obj_index) {
+            color = 0;
+            for (int i = 0; i < mpi->smprank; ++i) {
+                if (obj_indices[i] == my_obj_index) {
+                    color = MPI_UNDEFINED;
+                    break;
+                }
+            }
+        }
+    }
+    if (MPI_SUCCESS != MPI_Comm_split(mpi->commchan, color, mpi->rank,
+                                      &(lc->comm))) {
+        rc = QUO_ERR_MPI;
+        goto out;
+    }
+    lc->epoch = epoch;
+    lc->created = true;
+out:
+    if (obj_indices) free(obj_indices);
+    *out_comm = lc->created ? lc->comm : MPI_COMM_NULL;
+    return rc;
+}
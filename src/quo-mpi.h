@@ -117,7 +117,36 @@ quo_mpi_allgather(const void *sendbuf,
                   MPI_Datatype recvtype,
                   MPI_Comm comm);
 int
-quo_mpi_get_comm_by_type(const quo_mpi_t *mpi,
+quo_mpi_get_comm_by_type(quo_mpi_t *mpi,
                          QUO_obj_type_t target_type,
+                         int my_obj_index,
+                         unsigned long epoch,
                          MPI_Comm *out_comm);
+
+int
+quo_mpi_sm_bcast(quo_mpi_t *mpi,
+                 void *buffer,
+                 size_t nbytes,
+                 int root);
+
+int
+quo_mpi_sm_allreduce(quo_mpi_t *mpi,
+                     const void *sendbuf,
+                     void *recvbuf,
+                     int count,
+                     MPI_Datatype datatype,
+                     MPI_Op op);
+
+int
+quo_mpi_sm_allgather(quo_mpi_t *mpi,
+                     const void *sendbuf,
+                     size_t nbytes,
+                     void *recvbuf);
+
+int
+quo_mpi_get_leader_comm(quo_mpi_t *mpi,
+                        QUO_obj_type_t type,
+                        int my_obj_index,
+                        unsigned long epoch,
+                        MPI_Comm *out_comm);
 #endif
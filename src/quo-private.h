@@ -60,6 +60,9 @@
 #ifdef HAVE_STDBOOL_H
 #include <stdbool.h>
 #endif
+#ifdef HAVE_STDINT_H
+#include <stdint.h>
+#endif
 
 /** Library version. */
 #define QUO_VER    QUO_VERSION_CURRENT
@@ -142,6 +145,29 @@ do {                                                                           \
     }                                                                          \
 } while (0)
 
+/** Number of hardware resource types (see QUO_obj_type_t). */
+#define QUO_OBJ_NTYPES (QUO_OBJ_GROUP + 1)
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/* Atomics used by the lock-free shared-memory protocols.                     */
+/* ////////////////////////////////////////////////////////////////////////// */
+
+/** Atomic load with acquire semantics. */
+#define QUO_ATOMIC_LOAD_ACQ(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+/** Atomic store with release semantics. */
+#define QUO_ATOMIC_STORE_REL(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+/** Atomic fetch and add (returns the old value). */
+#define QUO_ATOMIC_FETCH_ADD(p, v)                                             \
+    __atomic_fetch_add((p), (v), __ATOMIC_ACQ_REL)
+/** Atomic load without ordering constraints. */
+#define QUO_ATOMIC_LOAD_RLX(p)     __atomic_load_n((p), __ATOMIC_RELAXED)
+/** Atomic store without ordering constraints. */
+#define QUO_ATOMIC_STORE_RLX(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+/** Acquire fence. */
+#define QUO_ATOMIC_FENCE_ACQ()     __atomic_thread_fence(__ATOMIC_ACQUIRE)
+/** Release fence. */
+#define QUO_ATOMIC_FENCE_REL()     __atomic_thread_fence(__ATOMIC_RELEASE)
+
 /* ////////////////////////////////////////////////////////////////////////// */
 /* Forward declarations. */
 struct quo_hwloc_t;
@@ -150,6 +176,30 @@ typedef struct quo_hwloc_t quo_hwloc_t;
 struct quo_mpi_t;
 typedef struct quo_mpi_t quo_mpi_t;
 
+struct quo_rebal_t;
+typedef struct quo_rebal_t quo_rebal_t;
+
+/** Number of QUO_auto_distrib results remembered by a context. */
+#define QUO_AUTO_DISTRIB_MEMO_LEN 8
+
+/** A remembered QUO_auto_distrib result. */
+typedef struct quo_auto_distrib_memo_t {
+    /** Whether or not this entry holds a result. */
+    bool valid;
+    /** Target resource type (a QUO_obj_type_t). */
+    int res_type;
+    /** Maximum number of processes per resource. */
+    int max_qids_per_res_type;
+    /** Whether or not the minimum-migration assignment was used. */
+    bool min_migration;
+    /** Bindings the result was calculated against: digests[qid] is the
+     * digest of qid's binding. Points into QUO_t's ad_memo_digests. */
+    uint64_t *digests;
+    /** Node-wide map: map[qid] is the resource index assigned to qid (-1 if
+     * it wasn't selected). Points into QUO_t's ad_memo_maps. */
+    int *map;
+} quo_auto_distrib_memo_t;
+
 /** QUO_t type definition. */
 struct QUO_t {
     /** Whether or not a context has been initialized. */
@@ -165,6 +215,20 @@ struct QUO_t {
     int qid;
     /** Number of processes that share a node with me. */
     int nqid;
+    /** Remembered QUO_auto_distrib results. */
+    quo_auto_distrib_memo_t ad_memo[QUO_AUTO_DISTRIB_MEMO_LEN];
+    /** Next memo entry to replace. */
+    int ad_memo_next;
+    /** Storage for the memo maps: nqid entries per memo entry. */
+    int *ad_memo_maps;
+    /** Storage for the memo binding digests: nqid entries per memo entry. */
+    uint64_t *ad_memo_digests;
+    /** Everyone's current binding digest (nqid entries). */
+    uint64_t *ad_digests;
+    /** Node-wide map of the latest assignment (allocated on first use). */
+    int *ad_map;
+    /** Phase timings and rebalance history (created on first use). */
+    quo_rebal_t *rebal;
 };
 
 #endif
@@ -0,0 +1,307 @@
+/*
+ * Copyright (c) 2013-2016 Los Alamos National Security, LLC
+ *                         All rights reserved.
+ *
+ * This software was produced under U.S. Government contract DE-AC52-06NA25396
+ * for Los Alamos National Laboratory (LANL), which is operated by Los Alamos
+ * National Security, LLC for the U.S. Department of Energy. The U.S. Government
+ * has rights to use, reproduce, and distribute this software.  NEITHER THE
+ * GOVERNMENT NOR LOS ALAMOS NATIONAL SECURITY, LLC MAKES ANY WARRANTY, EXPRESS
+ * OR IMPLIED, OR ASSUMES ANY LIABILITY FOR THE USE OF THIS SOFTWARE.  If
+ * software is modified to produce derivative works, such modified software
+ * should be clearly marked, so as not to confuse it with the version available
+ * from LANL.
+ *
+ * Additionally, redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * · Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * · Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * · Neither the name of Los Alamos National Security, LLC, Los Alamos
+ *   National Laboratory, LANL, the U.S. Government, nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY LOS ALAMOS NATIONAL SECURITY, LLC AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+ * NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL LOS ALAMOS NATIONAL
+ * SECURITY, LLC OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/**
+ * @file quo-rebalance.c Phase timing feedback for QUO_rebalance.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "quo.h"
+#include "quo-private.h"
+#include "quo-rebalance.h"
+#include "quo-mpi.h"
+#include "quo-sm.h"
+
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STDBOOL_H
+#include <stdbool.h>
+#endif
+
+/** Weight of the newest sample in a phase's running time average. */
+#define REBAL_EWMA_ALPHA 0.5
+/** Number of unchanged decisions after which a neighbor is tried again. */
+#define REBAL_REPROBE_PERIOD 8
+
+/** Node-wide state of a phase (lives in shared memory). */
+typedef struct rebal_phase_t {
+    /** The decision of the last QUO_rebalance. */
+    int max;
+    /** Number of QUO_rebalance calls in a row that kept the max. */
+    int nsteady;
+} rebal_phase_t;
+
+/** Rebalance instance definition. */
+struct quo_rebal_t {
+    /** Sum of the phase times I reported since the last QUO_rebalance. */
+    double sum[QUO_MAX_PHASES];
+    /** Number of phase times I reported since the last QUO_rebalance. */
+    int n[QUO_MAX_PHASES];
+    /** Node-wide history, set up by the first QUO_rebalance. */
+    quo_sm_t *sm;
+    /** Largest max_qids_per_res_type the history can hold. */
+    int nmax;
+    /** QUO_MAX_PHASES entries. */
+    rebal_phase_t *phases;
+    /** Average node time of phase p with max m: ewma[p * (nmax + 1) + m]. */
+    double *ewma;
+    /** Number of samples behind the averages, indexed like ewma. */
+    int *nsamples;
+};
+
+/* ////////////////////////////////////////////////////////////////////////// */
+static int
+rebal_get(QUO_t *q,
+          quo_rebal_t **out_rebal)
+{
+    if (!q->rebal) {
+        if (NULL == (q->rebal = calloc(1, sizeof(*q->rebal)))) {
+            QUO_OOR_COMPLAIN();
+            return QUO_ERR_OOR;
+        }
+    }
+    *out_rebal = q->rebal;
+    return QUO_SUCCESS;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Sets up the node-wide history. Node-local collective.
+ */
+static int
+rebal_history_setup(QUO_t *q,
+                    quo_rebal_t *rebal)
+{
+    int rc = QUO_SUCCESS;
+    char *sm_seg_path = NULL;
+    const int nmax = q->nqid;
+    const size_t nents = (size_t)QUO_MAX_PHASES * (nmax + 1);
+    const size_t seg_size = (QUO_MAX_PHASES * sizeof(rebal_phase_t)) +
+                            (nents * sizeof(double)) + (nents * sizeof(int));
+
+    if (QUO_SUCCESS != (rc = quo_sm_construct(&rebal->sm))) {
+        QUO_ERR_MSGRC("quo_sm_construct", rc);
+        goto out;
+    }
+    if (QUO_SUCCESS != (rc = quo_mpi_xchange_uniq_path(q->mpi, "rebal",
+                                                       &sm_seg_path))) {
+        QUO_ERR_MSGRC("quo_mpi_xchange_uniq_path", rc);
+        goto out;
+    }
+    /* The segment starts out zeroed: no decisions and no samples. */
+    if (0 == q->qid) {
+        if (QUO_SUCCESS != (rc = quo_sm_segment_create(rebal->sm, sm_seg_path,
+                                                       seg_size))) {
+            QUO_ERR_MSGRC("quo_sm_segment_create", rc);
+            goto out;
+        }
+    }
+    /* Wait for the segment to be created. */
+    if (QUO_SUCCESS != (rc = quo_mpi_sm_barrier(q->mpi))) {
+        QUO_ERR_MSGRC("quo_mpi_sm_barrier", rc);
+        goto out;
+    }
+    if (0 != q->qid) {
+        if (QUO_SUCCESS != (rc = quo_sm_segment_attach(rebal->sm, sm_seg_path,
+                                                       seg_size))) {
+            QUO_ERR_MSGRC("quo_sm_segment_attach", rc);
+            goto out;
+        }
+    }
+    /* Wait for attach completion. */
+    if (QUO_SUCCESS != (rc = quo_mpi_sm_barrier(q->mpi))) {
+        QUO_ERR_MSGRC("quo_mpi_sm_barrier", rc);
+        goto out;
+    }
+    /* Cleanup after everyone is done. */
+    if (0 == q->qid) (void)quo_sm_unlink(rebal->sm);
+
+    char *basep = (char *)quo_sm_get_basep(rebal->sm);
+    rebal->nmax = nmax;
+    rebal->phases = (rebal_phase_t *)basep;
+    rebal->ewma = (double *)(basep + (QUO_MAX_PHASES * sizeof(rebal_phase_t)));
+    rebal->nsamples = (int *)(rebal->ewma + nents);
+out:
+    if (sm_seg_path) free(sm_seg_path);
+    if (QUO_SUCCESS != rc && rebal->sm) {
+        (void)quo_sm_destruct(rebal->sm);
+        rebal->sm = NULL;
+    }
+    return rc;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Hill climbing over max_qids_per_res_type: records how long the phase took
+ * with the current max, then moves to an untried neighbor, or else to the
+ * neighbor (or stays with the max) that has the best average. A long stretch
+ * without change tries a neighbor again, so shifting load gets noticed.
+ * Only run by qid 0.
+ */
+static int
+rebal_decide(quo_rebal_t *rebal,
+             int phase_id,
+             int max,
+             int max_max,
+             double node_time)
+{
+    rebal_phase_t *phase = &rebal->phases[phase_id];
+    double *ewma = &rebal->ewma[(size_t)phase_id * (rebal->nmax + 1)];
+    int *nsamples = &rebal->nsamples[(size_t)phase_id * (rebal->nmax + 1)];
+    const int lo = (max > 1) ? max - 1 : 0;
+    const int hi = (max < max_max) ? max + 1 : 0;
+    int next = max;
+
+    /* nobody reported anything, so there is nothing to go by */
+    if (node_time < 0.0) return max;
+    ewma[max] = (0 == nsamples[max]) ? node_time :
+                (REBAL_EWMA_ALPHA * node_time) +
+                ((1.0 - REBAL_EWMA_ALPHA) * ewma[max]);
+    nsamples[max]++;
+
+    if (hi && 0 == nsamples[hi]) next = hi;
+    else if (lo && 0 == nsamples[lo]) next = lo;
+    else {
+        if (lo && ewma[lo] < ewma[next]) next = lo;
+        if (hi && ewma[hi] < ewma[next]) next = hi;
+    }
+    if (next != max) phase->nsteady = 0;
+    else if (++phase->nsteady >= REBAL_REPROBE_PERIOD) {
+        phase->nsteady = 0;
+        if (hi && (!lo || nsamples[hi] <= nsamples[lo])) next = hi;
+        else if (lo) next = lo;
+    }
+    return next;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+quo_rebalance_destruct(quo_rebal_t *rebal)
+{
+    if (!rebal) return QUO_ERR_INVLD_ARG;
+
+    if (rebal->sm) (void)quo_sm_destruct(rebal->sm);
+    free(rebal);
+
+    return QUO_SUCCESS;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_phase_report(QUO_t *q,
+                 int phase_id,
+                 double seconds)
+{
+    int rc = QUO_SUCCESS;
+    quo_rebal_t *rebal = NULL;
+
+    if (!q || phase_id < 0 || phase_id >= QUO_MAX_PHASES || !(seconds >= 0.0)) {
+        return QUO_ERR_INVLD_ARG;
+    }
+    QUO_NO_INIT_ACTION(q);
+    if (QUO_SUCCESS != (rc = rebal_get(q, &rebal))) return rc;
+    rebal->sum[phase_id] += seconds;
+    rebal->n[phase_id]++;
+    return QUO_SUCCESS;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_rebalance(QUO_t *q,
+              QUO_obj_type_t res_type,
+              int phase_id,
+              int *inout_max_qids_per_res_type,
+              int *out_selected,
+              int *out_res_index,
+              int flags)
+{
+    int rc = QUO_SUCCESS, nres = 0;
+    quo_rebal_t *rebal = NULL;
+    double my_time = -1.0, node_time = -1.0;
+
+    if (!q || phase_id < 0 || phase_id >= QUO_MAX_PHASES ||
+        !inout_max_qids_per_res_type || !out_selected || !out_res_index) {
+        return QUO_ERR_INVLD_ARG;
+    }
+    QUO_NO_INIT_ACTION(q);
+    if (QUO_SUCCESS != (rc = QUO_nobjs_by_type(q, res_type, &nres))) {
+        return rc;
+    }
+    if (0 == nres) return QUO_ERR_NOT_FOUND;
+    if (QUO_SUCCESS != (rc = rebal_get(q, &rebal))) return rc;
+    if (!rebal->sm) {
+        if (QUO_SUCCESS != (rc = rebal_history_setup(q, rebal))) return rc;
+    }
+    /* more than this many per resource can't all be selected anyway */
+    const int max_max = (q->nqid + nres - 1) / nres;
+    int max = *inout_max_qids_per_res_type;
+    if (max < 1) max = 1;
+    if (max > max_max) max = max_max;
+    if (rebal->n[phase_id] > 0) {
+        my_time = rebal->sum[phase_id] / rebal->n[phase_id];
+    }
+    rebal->sum[phase_id] = 0.0;
+    rebal->n[phase_id] = 0;
+    /* the phase took as long as its slowest process. this also guarantees
+     * that everyone is done reading the previous decision. */
+    if (QUO_SUCCESS != (rc = QUO_node_allreduce(q, &my_time, &node_time, 1,
+                                                MPI_DOUBLE, MPI_MAX))) {
+        return rc;
+    }
+    if (0 == q->qid) {
+        rebal->phases[phase_id].max = rebal_decide(rebal, phase_id, max,
+                                                   max_max, node_time);
+    }
+    if (QUO_SUCCESS != (rc = quo_mpi_sm_barrier(q->mpi))) return rc;
+    *inout_max_qids_per_res_type = rebal->phases[phase_id].max;
+    return QUO_auto_distrib_assign(q, res_type, *inout_max_qids_per_res_type,
+                                   out_selected, out_res_index, flags);
+}
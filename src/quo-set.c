@@ -65,12 +65,24 @@
 #ifdef HAVE_STRING_H
 #include <string.h>
 #endif
+#ifdef HAVE_STDINT_H
+#include <stdint.h>
+#endif
 #include <errno.h>
 
+/** Number of bits in a bitmap word. */
+#define WORD_NBITS 64
+
 /* ////////////////////////////////////////////////////////////////////////// */
 /**
- * This is a naive algorithm to compute the intersection of k sets. if this
- * approach ever becomes a performance bottleneck, then implement Baeza-Yates.
+ * Computes the k set intersection: the values that appear in at least two of
+ * the provided sets. Each set must be sorted in increasing order, have no
+ * duplicates, and only contain non-negative values.
+ *
+ * Every set is turned into a bitmap over [0, global_max] and folded into
+ * "seen once" and "seen at least twice" masks, one word at a time:
+ *     twice |= once & set; once |= set;
+ * This is O(k * n / 64) instead of the O(k^2 * n) all-pairs merge it replaced.
  *
  * Caller is responsible for freeing returned resources.
  */
@@ -81,14 +93,15 @@ quo_set_get_k_set_intersection(int nsets,
                                int **res,
                                int *res_len)
 {
+    int rc = QUO_SUCCESS;
     /* all set data are positive, so we don't have to worry about that */
     int global_max = -1;
-    /* "hash table" large enough to hold the largest set value. */
-    int *big_htab = NULL;
     /* length of the k set intersection */
     int ilen = 0;
-    /* size of big_htab */
-    size_t big_htab_size = 0;
+    /* number of words in each mask */
+    size_t nwords = 0;
+    /* seen once, seen at least twice, and the current set's masks */
+    uint64_t *once = NULL, *twice = NULL, *cur = NULL;
 
     if (!set_lens || !sets || !res || !res_len) return QUO_ERR_INVLD_ARG;
     *res = NULL; *res_len = 0;
@@ -111,61 +124,56 @@ quo_set_get_k_set_intersection(int nsets,
             if (global_max < curval) global_max = curval;
         }
     }
-    /* now that we know the global max, allocate an array large enough to
-     * accommodate that range. remember, values here should be from
-     * 0 - global_max. */
-    big_htab_size = (global_max + 1) * sizeof(*big_htab);
-    if (NULL == (big_htab = malloc(big_htab_size))) {
+    /* all sets are empty */
+    if (global_max < 0) return QUO_SUCCESS;
+    /* masks cover values 0 - global_max */
+    nwords = ((size_t)global_max / WORD_NBITS) + 1;
+    once = calloc(nwords, sizeof(*once));
+    twice = calloc(nwords, sizeof(*twice));
+    cur = calloc(nwords, sizeof(*cur));
+    if (!once || !twice || !cur) {
         QUO_OOR_COMPLAIN();
-        return QUO_ERR_OOR;
+        rc = QUO_ERR_OOR;
+        goto out;
     }
-    /* -1 indicates that the hash location has not yet been taken */
-    (void)memset(big_htab, -1, big_htab_size);
-    /* ////////////////////////////////////////////////////////////////////// */
-    /* start the naive k set intersection */
-    /* ////////////////////////////////////////////////////////////////////// */
-    for (int seta = 0; seta < nsets; ++seta) {
-        for (int setb = 0; setb < nsets; ++setb) {
-            int i = 0, j = 0;
-            if (seta == setb) continue;
-            while (i < set_lens[seta] && j < set_lens[setb]) {
-                /* no possible intersection */
-                if (0 == set_lens[seta] || 0 == set_lens[setb]) break;
-                while (i < set_lens[seta] && sets[seta][i] < sets[setb][j]) ++i;
-                if (i == set_lens[seta]) break;
-                while (j < set_lens[setb] && sets[setb][j] < sets[seta][i]) ++j;
-                if (j == set_lens[setb]) break;
-                if (sets[seta][i] == sets[setb][j]) {
-                    /* new entry */
-                    if (-1 == big_htab[sets[seta][i]]) {
-                        big_htab[sets[seta][i]] = sets[seta][i];
-                        ++ilen;
-                    }
-                }
-                ++i; ++j;
-            }
+    for (int set = 0; set < nsets; ++set) {
+        const int len = set_lens[set];
+        if (0 == len) continue;
+        /* sets are sorted, so only this word range is touched */
+        const size_t wlo = (size_t)sets[set][0] / WORD_NBITS;
+        const size_t whi = (size_t)sets[set][len - 1] / WORD_NBITS;
+        for (int elem = 0; elem < len; ++elem) {
+            const int v = sets[set][elem];
+            cur[v / WORD_NBITS] |= (uint64_t)1 << (v % WORD_NBITS);
         }
+        for (size_t w = wlo; w <= whi; ++w) {
+            twice[w] |= once[w] & cur[w];
+            once[w] |= cur[w];
+            cur[w] = 0;
+        }
+    }
+    for (size_t w = 0; w < nwords; ++w) {
+        ilen += __builtin_popcountll(twice[w]);
     }
     /* if no intersections found, we are done! */
-    if (0 == ilen) goto done;
+    if (0 == ilen) goto out;
     /* else return the set */
     if (NULL == (*res = calloc(ilen, sizeof(int)))) {
-        free(big_htab); big_htab = NULL;
         QUO_OOR_COMPLAIN();
-        return QUO_ERR_OOR;
+        rc = QUO_ERR_OOR;
+        goto out;
     }
     /* populate the result array - note this will always be sorted */
-    for (int i = 0, j = 0; i < global_max + 1; ++i) {
-        if (-1 != big_htab[i]) (*res)[j++] = big_htab[i];
+    for (size_t w = 0, j = 0; w < nwords; ++w) {
+        for (uint64_t bits = twice[w]; 0 != bits; bits &= bits - 1) {
+            (*res)[j++] = (int)(w * WORD_NBITS) + __builtin_ctzll(bits);
+        }
     }
     /* return result array length */
     *res_len = ilen;
-#if 0 /* debug */
-    for (int i = 0; i < ilen; ++i) {
-        printf("%d%s", (*res)[i], i + 1 == ilen ? "\n" : " ");
-    }
-#endif
-done:
-    if (big_htab) free(big_htab);
-    return QUO_SUCCESS;
+out:
+    if (once) free(once);
+    if (twice) free(twice);
+    if (cur) free(cur);
+    return rc;
 }
@@ -54,6 +54,7 @@
 #include "quo-set.h"
 #include "quo-hwloc.h"
 #include "quo-mpi.h"
+#include "quo-rebalance.h"
 
 #ifdef HAVE_STDLIB_H
 #include <stdlib.h>
@@ -64,6 +65,9 @@
 #ifdef HAVE_STDBOOL_H
 #include <stdbool.h>
 #endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
 #ifdef HAVE_SYS_TYPES_H
 #include <sys/types.h>
 #endif
@@ -71,6 +75,9 @@
 #include <unistd.h>
 #endif
 
+/** Number of words in a QUO_qid_mask_t. */
+#define QID_MASK_NWORDS (QUO_QID_MASK_NBITS / 64)
+
 /* ////////////////////////////////////////////////////////////////////////// */
 static int
 init_cached_attrs(QUO_t *q)
@@ -89,10 +96,40 @@ init_cached_attrs(QUO_t *q)
         QUO_ERR_MSGRC("QUO_id", rc);
         goto out;
     }
+    /* QUO_auto_distrib's memo. everyone needs it before the first exchange,
+     * so set it up here instead of on first use. */
+    const size_t nmemo = (size_t)QUO_AUTO_DISTRIB_MEMO_LEN * q->nqid;
+    q->ad_memo_maps = calloc(nmemo, sizeof(*q->ad_memo_maps));
+    q->ad_memo_digests = calloc(nmemo, sizeof(*q->ad_memo_digests));
+    q->ad_digests = calloc(q->nqid, sizeof(*q->ad_digests));
+    if (!q->ad_memo_maps || !q->ad_memo_digests || !q->ad_digests) {
+        QUO_OOR_COMPLAIN();
+        rc = QUO_ERR_OOR;
+        goto out;
+    }
 out:
     return rc;
 }
 
+/* ////////////////////////////////////////////////////////////////////////// */
+/**
+ * Gathers what the binding-dependent communicators need: the index of the
+ * object of the given type that encloses my binding (-1 if none) and my binding
+ * epoch.
+ */
+static int
+get_enclosing_obj_info(QUO_t *q,
+                       QUO_obj_type_t type,
+                       int *out_obj_index,
+                       unsigned long *out_epoch)
+{
+    int rc = QUO_SUCCESS;
+
+    rc = quo_hwloc_get_enclosing_obj_index(q->hwloc, type, out_obj_index);
+    if (QUO_SUCCESS != rc) return rc;
+    return quo_hwloc_bind_epoch(q->hwloc, out_epoch);
+}
+
 /* ////////////////////////////////////////////////////////////////////////// */
 static int
 construct_quoc(QUO_t **q)
@@ -182,9 +219,16 @@ QUO_free(QUO_t *q)
     if (q->hwloc) {
         if (QUO_SUCCESS != quo_hwloc_destruct(q->hwloc)) nerrs++;
     }
+    if (q->rebal) {
+        if (QUO_SUCCESS != quo_rebalance_destruct(q->rebal)) nerrs++;
+    }
     if (q->mpi) {
         if (QUO_SUCCESS != quo_mpi_destruct(q->mpi)) nerrs++;
     }
+    if (q->ad_memo_maps) free(q->ad_memo_maps);
+    if (q->ad_memo_digests) free(q->ad_memo_digests);
+    if (q->ad_digests) free(q->ad_digests);
+    if (q->ad_map) free(q->ad_map);
     free(q);
     return nerrs == 0 ? QUO_SUCCESS : QUO_ERR;
 }
@@ -234,50 +278,145 @@ QUO_qids_in_type(QUO_t *q,
                  int **out_qids)
 {
     int rc = QUO_ERR;
-    int tot_smpranks = 0;
-    int nsmpranks = 0;
-    int *smpranks = NULL;
+    int nqids = 0;
+    int *qids = NULL;
 
     if (!q || !out_nqids || !out_qids) return QUO_ERR_INVLD_ARG;
     /* make sure we are initialized before we continue */
     QUO_NO_INIT_ACTION(q);
     *out_nqids = 0; *out_qids = NULL;
-    /* set how many node ranks on the node */
-    tot_smpranks = q->nqid;
-    /* smp ranks are always monotonically increasing starting at 0 */
-    for (int rank = 0; rank < tot_smpranks; ++rank) {
-        /* whether or not the particular pid is in the given obj type */
-        int in_cpuset = 0;
-        /* the smp rank's pid */
-        pid_t rpid = 0;
-        if (QUO_SUCCESS != (rc = quo_mpi_smprank2pid(q->mpi, rank, &rpid))) {
-            /* rc set in failure path */
-            goto out;
-        }
-        rc = quo_hwloc_is_in_cpuset_by_type_id(q->hwloc, type, rpid,
-                                               in_type_index, &in_cpuset);
-        if (QUO_SUCCESS != rc) goto out;
-        /* if the rank's cpuset falls within the given obj, then add it */
-        if (in_cpuset) {
-            int *newsmpranks = realloc(smpranks, (nsmpranks + 1) * sizeof(int));
-            if (!newsmpranks) {
-                rc = QUO_ERR_OOR;
-                goto out;
-            }
-            /* add the newly found rank to the list and increment num found */
-            newsmpranks[nsmpranks++] = rank;
-            smpranks = newsmpranks;
-        }
+    /* can't have more than all of the node's ranks */
+    if (NULL == (qids = calloc(q->nqid, sizeof(*qids)))) {
+        QUO_OOR_COMPLAIN();
+        return QUO_ERR_OOR;
     }
-    *out_nqids = nsmpranks;
-    *out_qids = smpranks;
+    /* answered from the node-wide affinity table -- no per-rank syscalls */
+    rc = quo_hwloc_qids_in_type(q->hwloc, type, (unsigned)in_type_index,
+                                &nqids, qids);
+    if (QUO_SUCCESS != rc) goto out;
+    *out_nqids = nqids;
+    *out_qids = qids;
 out:
     if (QUO_SUCCESS != rc) {
-        if (smpranks) free(smpranks);
+        if (qids) free(qids);
     }
     return rc;
 }
 
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_qids_in_type_buf(QUO_t *q,
+                     QUO_obj_type_t type,
+                     int in_type_index,
+                     int max_qids,
+                     int *out_nqids,
+                     int *out_qids)
+{
+    if (!q || !out_nqids || !out_qids) return QUO_ERR_INVLD_ARG;
+    /* make sure we are initialized before we continue */
+    QUO_NO_INIT_ACTION(q);
+    *out_nqids = 0;
+    /* can't have more than all of the node's ranks */
+    if (max_qids < q->nqid) return QUO_ERR_INVLD_ARG;
+    return quo_hwloc_qids_in_type(q->hwloc, type, (unsigned)in_type_index,
+                                  out_nqids, out_qids);
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_qids_in_type_mask(QUO_t *q,
+                      QUO_obj_type_t type,
+                      int in_type_index,
+                      QUO_qid_mask_t *out_mask)
+{
+    if (!q || !out_mask) return QUO_ERR_INVLD_ARG;
+    /* make sure we are initialized before we continue */
+    QUO_NO_INIT_ACTION(q);
+    QUO_qid_mask_zero(out_mask);
+    if (q->nqid > QUO_QID_MASK_NBITS) return QUO_ERR_NOT_SUPPORTED;
+    return quo_hwloc_qids_in_type_mask(q->hwloc, type, (unsigned)in_type_index,
+                                       out_mask->bits, QID_MASK_NWORDS);
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+void
+QUO_qid_mask_zero(QUO_qid_mask_t *mask)
+{
+    if (mask) memset(mask, 0, sizeof(*mask));
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+void
+QUO_qid_mask_set(QUO_qid_mask_t *mask,
+                 int qid)
+{
+    if (!mask || qid < 0 || qid >= QUO_QID_MASK_NBITS) return;
+    mask->bits[qid / 64] |= (uint64_t)1 << (qid % 64);
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_qid_mask_isset(const QUO_qid_mask_t *mask,
+                   int qid)
+{
+    if (!mask || qid < 0 || qid >= QUO_QID_MASK_NBITS) return 0;
+    return (int)((mask->bits[qid / 64] >> (qid % 64)) & 1);
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+void
+QUO_qid_mask_and(QUO_qid_mask_t *out_mask,
+                 const QUO_qid_mask_t *a,
+                 const QUO_qid_mask_t *b)
+{
+    if (!out_mask || !a || !b) return;
+    for (int i = 0; i < QID_MASK_NWORDS; ++i) {
+        out_mask->bits[i] = a->bits[i] & b->bits[i];
+    }
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+void
+QUO_qid_mask_or(QUO_qid_mask_t *out_mask,
+                const QUO_qid_mask_t *a,
+                const QUO_qid_mask_t *b)
+{
+    if (!out_mask || !a || !b) return;
+    for (int i = 0; i < QID_MASK_NWORDS; ++i) {
+        out_mask->bits[i] = a->bits[i] | b->bits[i];
+    }
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_qid_mask_popcount(const QUO_qid_mask_t *mask)
+{
+    int n = 0;
+
+    if (!mask) return 0;
+    for (int i = 0; i < QID_MASK_NWORDS; ++i) {
+        n += __builtin_popcountll(mask->bits[i]);
+    }
+    return n;
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_qid_mask_next(const QUO_qid_mask_t *mask,
+                  int prev_qid)
+{
+    if (!mask) return -1;
+    int qid = (prev_qid < 0) ? 0 : prev_qid + 1;
+    if (qid >= QUO_QID_MASK_NBITS) return -1;
+    /* mask off what we have already seen in the first word */
+    uint64_t word = mask->bits[qid / 64] & (~(uint64_t)0 << (qid % 64));
+    for (int i = qid / 64; ; ) {
+        if (word) return (i * 64) + __builtin_ctzll(word);
+        if (++i >= QID_MASK_NWORDS) return -1;
+        word = mask->bits[i];
+    }
+}
+
 /* ////////////////////////////////////////////////////////////////////////// */
 int
 QUO_nobjs_by_type(QUO_t *q,
@@ -406,6 +545,28 @@ QUO_bind_push(QUO_t *q,
     return quo_hwloc_bind_push(q->hwloc, policy, type, (unsigned)obj_index);
 }
 
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_bind_push_cpuset(QUO_t *q,
+                     const char *cpuset_str)
+{
+    if (!q) return QUO_ERR_INVLD_ARG;
+    QUO_NO_INIT_ACTION(q);
+    return quo_hwloc_bind_push_cpuset(q->hwloc, cpuset_str);
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_bind_push_objs(QUO_t *q,
+                   const QUO_obj_type_t *types,
+                   const int *obj_indices,
+                   int nobjs)
+{
+    if (!q) return QUO_ERR_INVLD_ARG;
+    QUO_NO_INIT_ACTION(q);
+    return quo_hwloc_bind_push_objs(q->hwloc, types, obj_indices, nobjs);
+}
+
 /* ////////////////////////////////////////////////////////////////////////// */
 int
 QUO_bind_pop(QUO_t *q)
@@ -415,6 +576,78 @@ QUO_bind_pop(QUO_t *q)
     return quo_hwloc_bind_pop(q->hwloc);
 }
 
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_set_smt_policy(QUO_t *q,
+                   QUO_smt_policy_t policy)
+{
+    if (!q) return QUO_ERR_INVLD_ARG;
+    QUO_NO_INIT_ACTION(q);
+    return quo_hwloc_set_smt_policy(q->hwloc, policy);
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_bind_thread(QUO_t *q,
+                int tid,
+                int nthreads)
+{
+    if (!q) return QUO_ERR_INVLD_ARG;
+    QUO_NO_INIT_ACTION(q);
+    return quo_hwloc_bind_thread(q->hwloc, tid, nthreads);
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_membind_push(QUO_t *q,
+                 int flags)
+{
+    if (!q) return QUO_ERR_INVLD_ARG;
+    QUO_NO_INIT_ACTION(q);
+    return quo_hwloc_membind_push(q->hwloc, flags);
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_membind_pop(QUO_t *q)
+{
+    if (!q) return QUO_ERR_INVLD_ARG;
+    QUO_NO_INIT_ACTION(q);
+    return quo_hwloc_membind_pop(q->hwloc);
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_membind_register(QUO_t *q,
+                     const void *buf,
+                     size_t nbytes)
+{
+    if (!q) return QUO_ERR_INVLD_ARG;
+    QUO_NO_INIT_ACTION(q);
+    return quo_hwloc_membind_register(q->hwloc, buf, nbytes);
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_membind_unregister(QUO_t *q,
+                       const void *buf)
+{
+    if (!q) return QUO_ERR_INVLD_ARG;
+    QUO_NO_INIT_ACTION(q);
+    return quo_hwloc_membind_unregister(q->hwloc, buf);
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_membind_migrate_stats(QUO_t *q,
+                          size_t *out_nbytes,
+                          double *out_seconds)
+{
+    if (!q) return QUO_ERR_INVLD_ARG;
+    QUO_NO_INIT_ACTION(q);
+    return quo_hwloc_membind_migrate_stats(q->hwloc, out_nbytes, out_seconds);
+}
+
 /* ////////////////////////////////////////////////////////////////////////// */
 int
 QUO_barrier(QUO_t *q)
@@ -430,11 +663,113 @@ QUO_get_mpi_comm_by_type(QUO_t *q,
                          QUO_obj_type_t target_type,
                          MPI_Comm *out_comm)
 {
+    int rc = QUO_SUCCESS, obj_index = -1;
+    unsigned long epoch = 0;
+
+    if (!q || !out_comm) return QUO_ERR_INVLD_ARG;
+    /* make sure we are initialized before we continue */
+    QUO_NO_INIT_ACTION(q);
+
+    if (QUO_OBJ_MACHINE != target_type) {
+        rc = get_enclosing_obj_info(q, target_type, &obj_index, &epoch);
+        if (QUO_SUCCESS != rc) return rc;
+    }
+    return quo_mpi_get_comm_by_type(q->mpi, target_type, obj_index, epoch,
+                                    out_comm);
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_node_bcast(QUO_t *q,
+               void *buffer,
+               size_t nbytes,
+               int root_qid)
+{
+    if (!q || (!buffer && 0 != nbytes)) return QUO_ERR_INVLD_ARG;
+    /* make sure we are initialized before we continue */
+    QUO_NO_INIT_ACTION(q);
+    if (root_qid < 0 || root_qid >= q->nqid) return QUO_ERR_INVLD_ARG;
+
+    return quo_mpi_sm_bcast(q->mpi, buffer, nbytes, root_qid);
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_node_allreduce(QUO_t *q,
+                   const void *sendbuf,
+                   void *recvbuf,
+                   int count,
+                   MPI_Datatype datatype,
+                   MPI_Op op)
+{
+    if (!q) return QUO_ERR_INVLD_ARG;
+    /* make sure we are initialized before we continue */
+    QUO_NO_INIT_ACTION(q);
+
+    return quo_mpi_sm_allreduce(q->mpi, sendbuf, recvbuf, count, datatype, op);
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_node_allgather(QUO_t *q,
+                   const void *sendbuf,
+                   size_t nbytes,
+                   void *recvbuf)
+{
+    if (!q) return QUO_ERR_INVLD_ARG;
+    /* make sure we are initialized before we continue */
+    QUO_NO_INIT_ACTION(q);
+
+    return quo_mpi_sm_allgather(q->mpi, sendbuf, nbytes, recvbuf);
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_get_leader_comm(QUO_t *q,
+                    QUO_obj_type_t type,
+                    MPI_Comm *out_comm)
+{
+    int rc = QUO_SUCCESS, obj_index = -1;
+    unsigned long epoch = 0;
+
     if (!q || !out_comm) return QUO_ERR_INVLD_ARG;
     /* make sure we are initialized before we continue */
     QUO_NO_INIT_ACTION(q);
 
-    return quo_mpi_get_comm_by_type(q->mpi, target_type, out_comm);
+    if (QUO_OBJ_MACHINE != type) {
+        rc = get_enclosing_obj_info(q, type, &obj_index, &epoch);
+        if (QUO_SUCCESS != rc) return rc;
+    }
+    return quo_mpi_get_leader_comm(q->mpi, type, obj_index, epoch, out_comm);
+}
+
+/* ////////////////////////////////////////////////////////////////////////// */
+int
+QUO_query_all(QUO_t *q,
+              QUO_info_t *out_info)
+{
+    int rc = QUO_SUCCESS;
+    bool bound = false;
+
+    if (!q || !out_info) return QUO_ERR_INVLD_ARG;
+    QUO_NO_INIT_ACTION(q);
+    memset(out_info, 0, sizeof(*out_info));
+    for (int t = QUO_OBJ_MACHINE; t < QUO_OBJ_NTYPES; ++t) {
+        rc = quo_hwloc_get_nobjs_by_type(q->hwloc, (QUO_obj_type_t)t,
+                                         &out_info->nobjs[t]);
+        if (QUO_SUCCESS != rc) return rc;
+    }
+    if (QUO_SUCCESS != (rc = quo_mpi_nnodes(q->mpi, &out_info->nnodes))) {
+        return rc;
+    }
+    out_info->nqids = q->nqid;
+    out_info->qid = q->qid;
+    if (QUO_SUCCESS != (rc = quo_hwloc_bound(q->hwloc, q->pid, &bound))) {
+        return rc;
+    }
+    out_info->bound = (int)bound;
+    return quo_hwloc_get_cur_bind_words(q->hwloc, q->pid, out_info->cpuset,
+                                        QUO_INFO_CPUSET_NWORDS);
 }
 
 #if 0 // Disable for now...
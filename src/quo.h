@@ -53,6 +53,8 @@
 
 /* For MPI_Comm type */
 #include "mpi.h"
+/* For QUO_info_t */
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -65,7 +67,25 @@ extern "C" {
 struct QUO_t;
 /** Convenience typedef. */
 typedef struct QUO_t QUO_t;
-/** External QUO context type. */
+/**
+ * External QUO context type.
+ *
+ * \note
+ * Thread safety: once QUO_create returns, the read-only queries may be called
+ * concurrently from any number of threads (e.g., from within OpenMP parallel
+ * regions) and never take a lock.
+ * These are: QUO_version, QUO_nobjs_by_type, QUO_nobjs_in_type_by_type,
+ * QUO_nnumanodes, QUO_nsockets, QUO_ncores, QUO_npus, QUO_nnodes, QUO_nqids,
+ * QUO_id, QUO_bound, QUO_stringify_cbind, QUO_cpuset_in_type, QUO_qids_in_type
+ * (and its _buf and _mask flavors), and QUO_query_all. Topology information is
+ * an immutable snapshot taken at QUO_create time, and binding changes are
+ * published with a sequence lock, so a query running alongside a QUO_bind_push
+ * or QUO_bind_pop sees either the old or the new binding, never a mix.
+ * QUO_bind_thread only reads the process binding and binds the calling thread,
+ * so it, too, may be called by every thread of a parallel region at once.
+ * Everything else -- in particular, QUO_bind_push and QUO_bind_pop themselves,
+ * and all routines that communicate -- must be called by one thread at a time.
+ */
 typedef QUO_t * QUO_context;
 
 /**
@@ -111,7 +131,15 @@ typedef enum {
     /** Core. */
     QUO_OBJ_CORE,
     /** Processing unit (e.g. hardware thread). */
-    QUO_OBJ_PU
+    QUO_OBJ_PU,
+    /** Level 1 data (or unified) cache. */
+    QUO_OBJ_L1CACHE,
+    /** Level 2 data (or unified) cache. */
+    QUO_OBJ_L2CACHE,
+    /** Level 3 data (or unified) cache. Usually the last-level cache. */
+    QUO_OBJ_L3CACHE,
+    /** Innermost level of hwloc groups (e.g. dies or tiles, when reported). */
+    QUO_OBJ_GROUP
 } QUO_obj_type_t;
 
 /** Push policies that influence QUO_bind_push behavior. */
@@ -122,6 +150,90 @@ typedef enum {
     QUO_BIND_PUSH_OBJ
 } QUO_bind_push_policy_t;
 
+/** How bindings treat the PUs of a core (SMT siblings). See
+ * QUO_set_smt_policy. */
+typedef enum {
+    /** Process bindings keep all of their PUs. Threads are spread across cores
+     * and only share a core once every core has a thread. */
+    QUO_SMT_CORES_FIRST = 0,
+    /** Process bindings keep only the first PU of each core. Threads are
+     * spread across cores and never use sibling PUs (or share a core). */
+    QUO_SMT_ONE_PU_PER_CORE,
+    /** Process bindings keep all of their PUs. Threads are packed onto sibling
+     * PUs, filling a core before moving on to the next. Meant for
+     * memory-bound phases. */
+    QUO_SMT_SIBLINGS
+} QUO_smt_policy_t;
+
+/** Flags that influence QUO_membind_push behavior (may be OR'd). */
+typedef enum {
+    /** No extra behavior. */
+    QUO_MEMBIND_NONE = 0x0,
+    /** Fail rather than fall back when the binding cannot be enforced. */
+    QUO_MEMBIND_STRICT = 0x1,
+    /** Also move pages that were already touched (see QUO_membind_register).
+     * The matching QUO_membind_pop moves them back. */
+    QUO_MEMBIND_MIGRATE = 0x2
+} QUO_membind_flags_t;
+
+/** Flags that influence QUO_auto_distrib_assign behavior (may be OR'd). */
+typedef enum {
+    /** No extra behavior. */
+    QUO_AUTO_DISTRIB_NONE = 0x0,
+    /** Bind selected callers to their assigned resource. */
+    QUO_AUTO_DISTRIB_BIND = 0x1,
+    /** Use the optimal, minimum-migration assignment (QUO_auto_distrib_assign
+     * only). */
+    QUO_AUTO_DISTRIB_MIN_MIGRATION = 0x4
+} QUO_auto_distrib_flags_t;
+
+/** Maximum number of node-local processes a QUO_qid_mask_t can describe. */
+#define QUO_QID_MASK_NBITS 1024
+
+/** Fixed-size set of node-local QUO IDs (qids). Bit (qid % 64) of
+ * bits[qid / 64] is set if qid is in the set. */
+typedef struct QUO_qid_mask_t {
+    uint64_t bits[QUO_QID_MASK_NBITS / 64];
+} QUO_qid_mask_t;
+
+/** Number of 64-bit words in QUO_info_t's cpuset. */
+#define QUO_INFO_CPUSET_NWORDS 16
+
+/** Everything QUO_query_all knows about the caller, its job, and its node. */
+typedef struct QUO_info_t {
+    /** Number of objects of each type on the node, indexed by QUO_obj_type_t. */
+    int nobjs[QUO_OBJ_GROUP + 1];
+    /** Number of compute nodes in the job. */
+    int nnodes;
+    /** Number of node-local processes. */
+    int nqids;
+    /** Caller's node-local ID. */
+    int qid;
+    /** Whether or not the caller is bound (see QUO_bound). */
+    int bound;
+    /** Caller's current binding. PU with OS index i is in the set if bit
+     * (i % 64) of cpuset[i / 64] is set. PUs with OS indices >=
+     * 64 * QUO_INFO_CPUSET_NWORDS are not represented. */
+    uint64_t cpuset[QUO_INFO_CPUSET_NWORDS];
+} QUO_info_t;
+
+/** Number of distinct phase IDs (see QUO_phase_report). */
+#define QUO_MAX_PHASES 16
+
+/** A process's part in a job-wide placement (see QUO_global_place). */
+typedef struct QUO_placement_t {
+    /** 1 if the caller is active in the placement, 0 otherwise. */
+    int active;
+    /** Number of active processes on the caller's node. */
+    int nactive_on_node;
+    /** Number of active processes in the job. */
+    int nactive;
+    /** Resource the caller's binding is intended for (-1 if not active). */
+    int res_index;
+    /** Number of threads the caller should run (0 if not active). */
+    int nthreads;
+} QUO_placement_t;
+
 /* ////////////////////////////////////////////////////////////////////////// */
 /* ////////////////////////////////////////////////////////////////////////// */
 /* QUO API */
@@ -299,6 +411,11 @@ QUO_cpuset_in_type(QUO_context q,
  *
  * @retval QUO_SUCCESS if the operation completed successfully.
  *
+ * NOTES: Answered from a node-wide table in which every process publishes its
+ * current binding, so no communication takes place. The table only reflects
+ * bindings made through libquo (QUO_bind_push and friends); external changes
+ * to a process' affinity are not seen until its next push or pop.
+ *
  * \code{.c}
  * int nqids_enclosed_in_socket0 = 0;
  * int *qids_enclosed_in_socket0 = NULL;
@@ -317,6 +434,130 @@ QUO_qids_in_type(QUO_context q,
                  int *out_nqids,
                  int **out_qids);
 
+/**
+ * Like QUO_qids_in_type, but writes into a caller-provided buffer, so no
+ * memory is allocated.
+ *
+ * @param[in] q Constructed and initialized QUO_context.
+ *
+ * @param[in] type Hardware object type.
+ *
+ * @param[in] in_type_index type's ID (base 0).
+ *
+ * @param[in] max_qids Number of entries out_qids can hold. Must be at least
+ *                     the number of node-local processes (see QUO_nqids).
+ *
+ * @param[out] out_nqids Total number of node (job) processes that satisfy the
+ *             query criteria.
+ *
+ * @param[out] out_qids Caller-provided buffer that is filled with the QUO IDs
+ *             that met the query criteria (in increasing order).
+ *
+ * @retval QUO_SUCCESS if the operation completed successfully.
+ *
+ * \code{.c}
+ * // qids is sized once, e.g., to QUO_nqids entries //
+ * int nqids_in_socket0 = 0;
+ * if (QUO_SUCCESS != QUO_qids_in_type_buf(q, QUO_OBJ_SOCKET, 0, nqids,
+ *                                         &nqids_in_socket0, qids)) {
+ *     // error handling //
+ * }
+ * \endcode
+ */
+int
+QUO_qids_in_type_buf(QUO_context q,
+                     QUO_obj_type_t type,
+                     int in_type_index,
+                     int max_qids,
+                     int *out_nqids,
+                     int *out_qids);
+
+/**
+ * Like QUO_qids_in_type, but returns the QUO IDs that met the query criteria
+ * as a fixed-size mask, so no memory is allocated. See the QUO_qid_mask_*
+ * routines for operations on masks.
+ *
+ * @param[in] q Constructed and initialized QUO_context.
+ *
+ * @param[in] type Hardware object type.
+ *
+ * @param[in] in_type_index type's ID (base 0).
+ *
+ * @param[out] out_mask Set of QUO IDs that met the query criteria.
+ *
+ * @retval QUO_SUCCESS if the operation completed successfully.
+ *
+ * @retval QUO_ERR_NOT_SUPPORTED if there are more than QUO_QID_MASK_NBITS
+ *                               node-local processes.
+ *
+ * \code{.c}
+ * // which qids share both socket 0 and NUMA node 0? //
+ * QUO_qid_mask_t s0, n0, both;
+ * QUO_qids_in_type_mask(q, QUO_OBJ_SOCKET, 0, &s0);
+ * QUO_qids_in_type_mask(q, QUO_OBJ_NUMANODE, 0, &n0);
+ * QUO_qid_mask_and(&both, &s0, &n0);
+ * for (int qid = QUO_qid_mask_next(&both, -1); qid != -1;
+ *      qid = QUO_qid_mask_next(&both, qid)) {
+ *     // do stuff //
+ * }
+ * \endcode
+ */
+int
+QUO_qids_in_type_mask(QUO_context q,
+                      QUO_obj_type_t type,
+                      int in_type_index,
+                      QUO_qid_mask_t *out_mask);
+
+/**
+ * Empties a QUO ID mask.
+ */
+void
+QUO_qid_mask_zero(QUO_qid_mask_t *mask);
+
+/**
+ * Adds qid to a QUO ID mask. Out-of-range qids are ignored.
+ */
+void
+QUO_qid_mask_set(QUO_qid_mask_t *mask,
+                 int qid);
+
+/**
+ * Returns 1 if qid is in the QUO ID mask, 0 otherwise.
+ */
+int
+QUO_qid_mask_isset(const QUO_qid_mask_t *mask,
+                   int qid);
+
+/**
+ * out_mask = a & b. out_mask may alias either input.
+ */
+void
+QUO_qid_mask_and(QUO_qid_mask_t *out_mask,
+                 const QUO_qid_mask_t *a,
+                 const QUO_qid_mask_t *b);
+
+/**
+ * out_mask = a | b. out_mask may alias either input.
+ */
+void
+QUO_qid_mask_or(QUO_qid_mask_t *out_mask,
+                const QUO_qid_mask_t *a,
+                const QUO_qid_mask_t *b);
+
+/**
+ * Returns the number of QUO IDs in the mask.
+ */
+int
+QUO_qid_mask_popcount(const QUO_qid_mask_t *mask);
+
+/**
+ * Returns the smallest qid in the mask that is greater than prev_qid, or -1 if
+ * there is none. Pass -1 to get the first one.
+ */
+int
+QUO_qid_mask_next(const QUO_qid_mask_t *mask,
+                  int prev_qid);
+
 /**
  * Query routine that returns the total number of NUMA nodes that are
  * present on the caller's system.
@@ -513,6 +754,75 @@ QUO_bind_push(QUO_context q,
               QUO_obj_type_t type,
               int obj_index);
 
+/**
+ * Routine that changes the caller's process binding policy to an explicit
+ * cpuset. Like QUO_bind_push, the new policy is maintained in the current
+ * context's stack; revert to the previous one by calling QUO_bind_pop.
+ *
+ * @param[in] q Constructed and initialized QUO_context.
+ *
+ * @param[in] cpuset_str The PUs (by OS index) to bind to, either in list
+ *                       format (e.g. "4-7,12") or in hwloc's mask format
+ *                       (e.g. "0x000010f0"). Must be a non-empty subset of the
+ *                       machine's PUs.
+ *
+ * @retval QUO_SUCCESS if the operation completed successfully.
+ *
+ * @retval QUO_ERR_INVLD_ARG if cpuset_str cannot be parsed or does not name a
+ *                           valid cpuset.
+ *
+ * \code{.c}
+ * if (QUO_SUCCESS != QUO_bind_push_cpuset(q, "4-7")) {
+ *     // error handling //
+ * }
+ * // revert to previous process binding policy //
+ * if (QUO_SUCCESS != QUO_bind_pop(q)) {
+ *     // error handling //
+ * }
+ * \endcode
+ */
+int
+QUO_bind_push_cpuset(QUO_context q,
+                     const char *cpuset_str);
+
+/**
+ * Routine that changes the caller's process binding policy to the union of
+ * the given objects. Like QUO_bind_push, the new policy is maintained in the
+ * current context's stack; revert to the previous one by calling QUO_bind_pop.
+ *
+ * @param[in] q Constructed and initialized QUO_context.
+ *
+ * @param[in] types Type of each object.
+ *
+ * @param[in] obj_indices Index (base 0) of each object within its type.
+ *
+ * @param[in] nobjs Number of objects (length of types and obj_indices).
+ *
+ * @retval QUO_SUCCESS if the operation completed successfully.
+ *
+ * @retval QUO_ERR_INVLD_ARG if any of the objects does not exist.
+ *
+ * \code{.c}
+ * // bind to the first PU of cores 0 and 1 (two PUs per core assumed) //
+ * const QUO_obj_type_t types[2] = {QUO_OBJ_PU, QUO_OBJ_PU};
+ * const int pus[2] = {0, 2};
+ * if (QUO_SUCCESS != QUO_bind_push_objs(q, types, pus, 2)) {
+ *     // error handling //
+ * }
+ * // cores 4 and 5 //
+ * const QUO_obj_type_t ctypes[2] = {QUO_OBJ_CORE, QUO_OBJ_CORE};
+ * const int cores[2] = {4, 5};
+ * if (QUO_SUCCESS != QUO_bind_push_objs(q, ctypes, cores, 2)) {
+ *     // error handling //
+ * }
+ * \endcode
+ */
+int
+QUO_bind_push_objs(QUO_context q,
+                   const QUO_obj_type_t *types,
+                   const int *obj_indices,
+                   int nobjs);
+
 /**
  * Routine that changes the caller's process binding policy by replacing
  * it with the policy at the top of the provided context's process bind stack.
@@ -536,6 +846,207 @@ QUO_bind_push(QUO_context q,
 int
 QUO_bind_pop(QUO_context q);
 
+/**
+ * Routine that sets how subsequent bindings treat SMT siblings (the PUs of a
+ * core). The policy applies to QUO_bind_push (and so to
+ * QUO_AUTO_DISTRIB_BIND) and to QUO_bind_thread; QUO_bind_push_cpuset and
+ * QUO_bind_push_objs bind to exactly the PUs they are given. Bindings that
+ * are already on the stack are not changed. The default is
+ * QUO_SMT_CORES_FIRST.
+ *
+ * @param[in] q Constructed and initialized QUO_context.
+ *
+ * @param[in] policy The new SMT policy.
+ *
+ * @retval QUO_SUCCESS if the operation completed successfully.
+ *
+ * @retval QUO_ERR_INVLD_ARG if policy is not a QUO_smt_policy_t.
+ *
+ * \code{.c}
+ * // compute-bound phase: one PU per core //
+ * QUO_set_smt_policy(q, QUO_SMT_ONE_PU_PER_CORE);
+ * if (QUO_SUCCESS != QUO_bind_push(q, QUO_BIND_PUSH_PROVIDED,
+ *                                  QUO_OBJ_SOCKET, 0)) {
+ *     // error handling //
+ * }
+ * // ... //
+ * QUO_bind_pop(q);
+ * // memory-bound phase: use the siblings, too //
+ * QUO_set_smt_policy(q, QUO_SMT_SIBLINGS);
+ * \endcode
+ */
+int
+QUO_set_smt_policy(QUO_context q,
+                   QUO_smt_policy_t policy);
+
+/**
+ * Routine that binds the calling thread to one PU of the caller's current
+ * process binding, chosen by the SMT policy (see QUO_set_smt_policy) from the
+ * thread's ID. Thread bindings are not kept on the bind stack: the next
+ * QUO_bind_push or QUO_bind_pop rebinds the whole process (even if its binding
+ * doesn't change), which replaces them. Unlike most routines, this one may be
+ * called concurrently by all threads, as long as no other thread pushes or
+ * pops at the same time.
+ *
+ * @param[in] q Constructed and initialized QUO_context.
+ *
+ * @param[in] tid The calling thread's ID (base 0), e.g. omp_get_thread_num().
+ *
+ * @param[in] nthreads Number of threads that share the process binding, e.g.
+ *                     omp_get_num_threads().
+ *
+ * @retval QUO_SUCCESS if the operation completed successfully.
+ *
+ * @retval QUO_ERR_INVLD_ARG if tid is not in [0, nthreads), or if the SMT
+ *         policy is QUO_SMT_ONE_PU_PER_CORE and nthreads exceeds the number of
+ *         cores in the process binding: that policy never puts two threads on
+ *         one core, so it has no PU to give the extra ones.
+ *
+ * @retval QUO_ERR_NOT_SUPPORTED if thread binding is not supported.
+ *
+ * \code{.c}
+ * #pragma omp parallel
+ * {
+ *     if (QUO_SUCCESS != QUO_bind_thread(q, omp_get_thread_num(),
+ *                                        omp_get_num_threads())) {
+ *         // error handling //
+ *     }
+ * }
+ * \endcode
+ */
+int
+QUO_bind_thread(QUO_context q,
+                int tid,
+                int nthreads);
+
+/**
+ * Routine that binds the caller's memory allocation policy to the NUMA nodes
+ * of its current process binding, so that new allocations stay local to the
+ * cores it runs on. The previous memory binding is maintained in the current
+ * context's memory bind stack, apart from the CPU bind stack.
+ *
+ * @param[in] q Constructed and initialized QUO_context.
+ *
+ * @param[in] flags Bitwise OR of QUO_membind_flags_t values.
+ *
+ * @retval QUO_SUCCESS if the operation completed successfully.
+ *
+ * @retval QUO_ERR_NOT_SUPPORTED if memory binding is not supported. The
+ *         previous memory binding is restored and nothing is pushed.
+ *
+ * \note
+ * Only the calling thread's policy may change on some systems (e.g. Linux).
+ * Threads created afterwards inherit it, so call this before spawning threads.
+ * Pages that were already touched are not moved unless QUO_MEMBIND_MIGRATE is
+ * provided. To revert to the previous memory binding call QUO_membind_pop.
+ *
+ * \code{.c}
+ * // bind to socket 0 and keep new allocations on its NUMA nodes //
+ * if (QUO_SUCCESS != QUO_bind_push(q, QUO_BIND_PUSH_PROVIDED,
+ *                                  QUO_OBJ_SOCKET, 0)) {
+ *     // error handling //
+ * }
+ * if (QUO_SUCCESS != QUO_membind_push(q, QUO_MEMBIND_NONE)) {
+ *     // error handling //
+ * }
+ * // ... //
+ * if (QUO_SUCCESS != QUO_membind_pop(q)) {
+ *     // error handling //
+ * }
+ * if (QUO_SUCCESS != QUO_bind_pop(q)) {
+ *     // error handling //
+ * }
+ * \endcode
+ */
+int
+QUO_membind_push(QUO_context q,
+                 int flags);
+
+/**
+ * Routine that reverts the caller's memory allocation policy to the one that
+ * was in effect before the matching QUO_membind_push.
+ *
+ * @param[in] q Constructed and initialized QUO_context.
+ *
+ * @retval QUO_SUCCESS if the operation completed successfully.
+ *
+ * @retval QUO_ERR_POP if there is no matching QUO_membind_push.
+ */
+int
+QUO_membind_pop(QUO_context q);
+
+/**
+ * Routine that registers a buffer to move when the memory binding changes with
+ * QUO_MEMBIND_MIGRATE. While no buffers are registered, migrating memory
+ * binding changes move all of the caller's pages instead.
+ *
+ * @param[in] q Constructed and initialized QUO_context.
+ *
+ * @param[in] buf Start of the buffer.
+ *
+ * @param[in] nbytes Length of the buffer (in B).
+ *
+ * @retval QUO_SUCCESS if the operation completed successfully.
+ *
+ * \code{.c}
+ * // keep the working set local to socket 1 //
+ * if (QUO_SUCCESS != QUO_membind_register(q, field, field_nbytes)) {
+ *     // error handling //
+ * }
+ * if (QUO_SUCCESS != QUO_bind_push(q, QUO_BIND_PUSH_PROVIDED,
+ *                                  QUO_OBJ_SOCKET, 1)) {
+ *     // error handling //
+ * }
+ * if (QUO_SUCCESS != QUO_membind_push(q, QUO_MEMBIND_MIGRATE)) {
+ *     // error handling //
+ * }
+ * size_t nbytes = 0;
+ * double secs = 0.0;
+ * if (QUO_SUCCESS != QUO_membind_migrate_stats(q, &nbytes, &secs)) {
+ *     // error handling //
+ * }
+ * printf("moved %zu B in %lf s\n", nbytes, secs);
+ * \endcode
+ */
+int
+QUO_membind_register(QUO_context q,
+                     const void *buf,
+                     size_t nbytes);
+
+/**
+ * Routine that removes a buffer added by QUO_membind_register.
+ *
+ * @param[in] q Constructed and initialized QUO_context.
+ *
+ * @param[in] buf Start of the buffer, as provided to QUO_membind_register.
+ *
+ * @retval QUO_SUCCESS if the operation completed successfully.
+ *
+ * @retval QUO_ERR_NOT_FOUND if buf is not registered.
+ */
+int
+QUO_membind_unregister(QUO_context q,
+                       const void *buf);
+
+/**
+ * Query routine that returns what the most recent migrating memory binding
+ * change (QUO_membind_push with QUO_MEMBIND_MIGRATE or its QUO_membind_pop)
+ * moved, and how long it took.
+ *
+ * @param[in] q Constructed and initialized QUO_context.
+ *
+ * @param[out] out_nbytes Number of bytes moved to the new NUMA nodes. 0 where
+ *                        page locations cannot be queried.
+ *
+ * @param[out] out_seconds Time (in s) the change took.
+ *
+ * @retval QUO_SUCCESS if the operation completed successfully.
+ */
+int
+QUO_membind_migrate_stats(QUO_context q,
+                          size_t *out_nbytes,
+                          double *out_seconds);
+
 /**
  * Routine that acts as a compute node barrier. All context-initializing
  * processes on a node MUST call this in order for everyone to proceed past the
@@ -593,6 +1104,15 @@ QUO_barrier(QUO_context q);
  *
  * @retval QUO_SUCCESS if the operation completed successfully.
  *
+ * \note All node-local processes must call this routine. The node-wide
+ * assignment is calculated once, by qid 0, from the node-wide affinity table
+ * and shared, so every process acts on the same bindings. It is also
+ * remembered by the context: calls with the same arguments reuse it, at the
+ * cost of a single node-local allgather (one shared-memory barrier), whenever
+ * every node-local process is bound like it was when it was calculated. That
+ * includes coming back to the same bindings, e.g. after a QUO_bind_push and
+ * the matching QUO_bind_pop.
+ *
  * \code{.c}
  * int res_assigned = 0;
  * if (QUO_SUCCESS != QUO_auto_distrib(q, QUO_OBJ_SOCKET,
@@ -608,6 +1128,317 @@ QUO_auto_distrib(QUO_context q,
                  int *out_selected);
 
 /**
+ * Like QUO_auto_distrib, but also returns the resource the caller was assigned
+ * and can apply the binding in the same step.
+ *
+ * @param[in] q Constructed and initialized QUO_context.
+ *
+ * @param[in] distrib_over_this The target hardware resource on which processes
+ *                              will be evenly distributed.
+ *
+ * @param[in] max_qids_per_res_type The maximum number of processes that will be
+ *                                  assigned to each resource.
+ *
+ * @param[out] out_selected Flag indicating whether or not i was chosen in the
+ *                          work distribution. 1 means I was chosen, 0
+ *                          otherwise.
+ *
+ * @param[out] out_res_index Index of the distrib_over_this resource i was
+ *                           assigned, or -1 if i wasn't chosen.
+ *
+ * @param[in] flags Bitwise OR of QUO_auto_distrib_flags_t values. With
+ *                  QUO_AUTO_DISTRIB_BIND, a chosen caller's binding is pushed
+ *                  to its resource (pop it with QUO_bind_pop). With
+ *                  QUO_AUTO_DISTRIB_MIN_MIGRATION, qids are matched to the
+ *                  max_qids_per_res_type slots of every resource such that as
+ *                  little of their current bindings as possible has to move:
+ *                  every slot is filled if there are enough processes (the
+ *                  default assignment can leave resources idle when bindings
+ *                  partially overlap).
+ *
+ * @retval QUO_SUCCESS if the operation completed successfully.
+ *
+ * \note The node-wide assignment can be fetched with
+ * QUO_auto_distrib_get_map.
+ *
+ * \code{.c}
+ * int selected = 0, socket = -1;
+ * if (QUO_SUCCESS != QUO_auto_distrib_assign(q, QUO_OBJ_SOCKET, 2,
+ *                                            &selected, &socket,
+ *                                            QUO_AUTO_DISTRIB_BIND)) {
+ *     // error handling //
+ * }
+ * if (selected) {
+ *     // work on socket, then QUO_bind_pop //
+ * }
+ * \endcode
+ */
+int
+QUO_auto_distrib_assign(QUO_context q,
+                        QUO_obj_type_t distrib_over_this,
+                        int max_qids_per_res_type,
+                        int *out_selected,
+                        int *out_res_index,
+                        int flags);
+
+/**
+ * Load-aware flavor of QUO_auto_distrib_assign. Each process supplies the cost
+ * of its work and processes are assigned, costliest first, to the least loaded
+ * resource that has fewer than max_qids_per_res_type processes (LPT
+ * scheduling). Among equally loaded resources, one the caller already covers
+ * is preferred. Processes left over once every resource is full aren't
+ * selected. This is a node-local collective: every process on the node must
+ * call it with the same distrib_over_this and max_qids_per_res_type.
+ *
+ * @param[in] q Constructed and initialized QUO_context.
+ *
+ * @param[in] distrib_over_this The target hardware resource on which processes
+ *                              will be distributed.
+ *
+ * @param[in] max_qids_per_res_type The maximum number of processes that will be
+ *                                  assigned to each resource.
+ *
+ * @param[in] cost The caller's (non-negative) amount of work, in any unit that
+ *                 is consistent across the node.
+ *
+ * @param[out] out_selected 1 if I was chosen, 0 otherwise.
+ *
+ * @param[out] out_res_index Index of the resource i was assigned, or -1.
+ *
+ * @param[in] flags Bitwise OR of QUO_auto_distrib_flags_t values.
+ *
+ * @retval QUO_SUCCESS if the operation completed successfully.
+ *
+ * @retval QUO_ERR_INVLD_ARG on every node-local process if any of them passed a
+ *         negative (or NaN) cost.
+ *
+ * \code{.c}
+ * int selected = 0, numa = -1;
+ * if (QUO_SUCCESS != QUO_auto_distrib_weighted(q, QUO_OBJ_NUMANODE, 4,
+ *                                              (double)my_ncells,
+ *                                              &selected, &numa,
+ *                                              QUO_AUTO_DISTRIB_BIND)) {
+ *     // error handling //
+ * }
+ * \endcode
+ */
+int
+QUO_auto_distrib_weighted(QUO_context q,
+                          QUO_obj_type_t distrib_over_this,
+                          int max_qids_per_res_type,
+                          double cost,
+                          int *out_selected,
+                          int *out_res_index,
+                          int flags);
+
+/**
+ * Nested flavor of QUO_auto_distrib_assign: distributes processes over
+ * levels[0] (at most max_qids_per_res_type[0] per resource), then the
+ * processes given each levels[0] resource over the levels[1] resources inside
+ * of it, and so on. Every level uses the minimum-migration assignment (see
+ * QUO_AUTO_DISTRIB_MIN_MIGRATION). The whole calculation is done by qid 0
+ * from the node-wide affinity table and shared with the rest of the node, so
+ * all node-local processes must call this routine.
+ *
+ * @param[in] q Constructed and initialized QUO_context.
+ *
+ * @param[in] levels nlevels resource types, outermost first. Every resource of
+ *                   a level must lie inside exactly one resource of the level
+ *                   above it (e.g. QUO_OBJ_SOCKET, QUO_OBJ_CORE).
+ *
+ * @param[in] max_qids_per_res_type nlevels per-resource maximums, one for each
+ *                                  level.
+ *
+ * @param[in] nlevels Number of levels.
+ *
+ * @param[out] out_selected 1 if I was chosen at every level, 0 otherwise.
+ *
+ * @param[out] out_leaf_index Index of the levels[nlevels - 1] resource i was
+ *                            assigned, or -1.
+ *
+ * @param[in] flags Bitwise OR of QUO_auto_distrib_flags_t values. With
+ *                  QUO_AUTO_DISTRIB_BIND, the leaf binding is pushed.
+ *
+ * @retval QUO_SUCCESS if the operation completed successfully.
+ *
+ * \code{.c}
+ * // two per socket, then one per core within that socket
+ * const QUO_obj_type_t levels[2] = {QUO_OBJ_SOCKET, QUO_OBJ_CORE};
+ * const int maxes[2] = {2, 1};
+ * int selected = 0, core = -1;
+ * if (QUO_SUCCESS != QUO_auto_distrib_hier(q, levels, maxes, 2, &selected,
+ *                                          &core, QUO_AUTO_DISTRIB_BIND)) {
+ *     // error handling //
+ * }
+ * \endcode
+ */
+int
+QUO_auto_distrib_hier(QUO_context q,
+                      const QUO_obj_type_t *levels,
+                      const int *max_qids_per_res_type,
+                      int nlevels,
+                      int *out_selected,
+                      int *out_leaf_index,
+                      int flags);
+
+/**
+ * Job-wide placement. Picks how many processes are active on every node such
+ * that each node's share of the requested total follows its share of the job's
+ * PUs, then picks the active processes on every node with the
+ * minimum-migration assignment (see QUO_AUTO_DISTRIB_MIN_MIGRATION), dealing
+ * them out evenly over the resources of the given type. Each active process
+ * is told which resource it is intended for and how many threads fill that
+ * resource. Node-local resource counts are combined over the node-leader
+ * communicator (see QUO_get_leader_comm), so this routine is collective over
+ * the initializing communicator.
+ *
+ * @param[in] q Constructed and initialized QUO_context.
+ *
+ * @param[in] res_type The resource type active processes are placed on.
+ *
+ * @param[in] nactive Number of active processes wanted across the job. If
+ *                    less than 1, one per resource on every node is used.
+ *                    Nodes never get more active processes than they have
+ *                    processes, so fewer may be chosen.
+ *
+ * @param[in] flags Bitwise OR of QUO_auto_distrib_flags_t values. With
+ *                  QUO_AUTO_DISTRIB_BIND, active processes push their
+ *                  intended binding.
+ *
+ * @param[out] out_placement The caller's part in the placement.
+ *
+ * @retval QUO_SUCCESS if the operation completed successfully.
+ *
+ * \code{.c}
+ * QUO_placement_t p;
+ * if (QUO_SUCCESS != QUO_global_place(q, QUO_OBJ_SOCKET, 0,
+ *                                     QUO_AUTO_DISTRIB_BIND, &p)) {
+ *     // error handling //
+ * }
+ * if (p.active) {
+ *     // threaded phase with p.nthreads threads, then QUO_bind_pop //
+ * }
+ * \endcode
+ */
+int
+QUO_global_place(QUO_context q,
+                 QUO_obj_type_t res_type,
+                 int nactive,
+                 int flags,
+                 QUO_placement_t *out_placement);
+
+/**
+ * Records how long the caller spent in one instance of a phase. The times are
+ * kept by the caller until the next QUO_rebalance of that phase. Not
+ * collective.
+ *
+ * @param[in] q Constructed and initialized QUO_context.
+ *
+ * @param[in] phase_id Application-chosen phase ID in [0, QUO_MAX_PHASES).
+ *
+ * @param[in] seconds Non-negative time spent in the phase.
+ *
+ * @retval QUO_SUCCESS if the operation completed successfully.
+ */
+int
+QUO_phase_report(QUO_context q,
+                 int phase_id,
+                 double seconds);
+
+/**
+ * Feedback-driven QUO_auto_distrib_assign. The phase's time since the last
+ * call (that of its slowest process) is added to a node-wide history, kept in
+ * shared memory, of how long the phase took with each max_qids_per_res_type.
+ * A new max is then chosen by hill climbing on that history: untried
+ * neighbors are tried first, otherwise the best of the current max and its
+ * neighbors is kept, and neighbors are retried now and then so that shifting
+ * load is noticed. Processes are then distributed with the new max. Always
+ * rebalance a phase over the same resource type. This is a node-local
+ * collective.
+ *
+ * @param[in] q Constructed and initialized QUO_context.
+ *
+ * @param[in] res_type The target hardware resource.
+ *
+ * @param[in] phase_id Phase ID used with QUO_phase_report.
+ *
+ * @param[in,out] inout_max_qids_per_res_type The max the phase last ran with
+ *                                            on input; the suggested max on
+ *                                            output.
+ *
+ * @param[out] out_selected 1 if I was chosen with the new max, 0 otherwise.
+ *
+ * @param[out] out_res_index Index of the resource i was assigned, or -1.
+ *
+ * @param[in] flags Bitwise OR of QUO_auto_distrib_flags_t values, used as in
+ *                  QUO_auto_distrib_assign (e.g. QUO_AUTO_DISTRIB_BIND to
+ *                  apply the new binding).
+ *
+ * @retval QUO_SUCCESS if the operation completed successfully.
+ *
+ * \code{.c}
+ * int max = 1, selected = 0, socket = -1;
+ * for (int step = 0; step < nsteps; ++step) {
+ *     QUO_rebalance(q, QUO_OBJ_SOCKET, 0, &max, &selected, &socket,
+ *                   QUO_AUTO_DISTRIB_BIND);
+ *     if (selected) {
+ *         double start = MPI_Wtime();
+ *         // threaded phase //
+ *         QUO_phase_report(q, 0, MPI_Wtime() - start);
+ *         QUO_bind_pop(q);
+ *     }
+ * }
+ * \endcode
+ */
+int
+QUO_rebalance(QUO_context q,
+              QUO_obj_type_t res_type,
+              int phase_id,
+              int *inout_max_qids_per_res_type,
+              int *out_selected,
+              int *out_res_index,
+              int flags);
+
+/**
+ * Returns the node-wide map of the caller's latest QUO_auto_distrib,
+ * QUO_auto_distrib_assign, QUO_auto_distrib_weighted, QUO_auto_distrib_hier,
+ * QUO_global_place, or QUO_rebalance: which resource every node-local process
+ * was assigned. Every node-local process gets the same map, so the node
+ * leader (qid 0) can report it. No communication takes place.
+ *
+ * @param[in] q Constructed and initialized QUO_context.
+ *
+ * @param[out] out_map out_map[qid] is the index of the resource assigned to
+ *                     qid, or -1 if qid wasn't chosen. Must be able to hold
+ *                     one entry per node-local process (see QUO_nqids).
+ *
+ * @retval QUO_SUCCESS if the operation completed successfully.
+ *
+ * @retval QUO_ERR_NOT_FOUND if no assignment has been made yet.
+ *
+ * \code{.c}
+ * if (0 == qid) {
+ *     if (QUO_SUCCESS != QUO_auto_distrib_get_map(q, map)) {
+ *         // error handling //
+ *     }
+ *     for (int i = 0; i < nqids; ++i) printf("%d -> %d\n", i, map[i]);
+ * }
+ * \endcode
+ */
+int
+QUO_auto_distrib_get_map(QUO_context q,
+                         int *out_map);
+
+/**
+ * Returns a communicator containing the node-local processes that share a
+ * hardware object of the given type with the caller. For QUO_OBJ_MACHINE, that
+ * is every context-initializing process on the node. For all other types, it
+ * is the processes whose current binding lies within the same object as the
+ * caller's (e.g., all processes bound within my socket). Processes whose
+ * binding does not lie within a single object of the given type get
+ * MPI_COMM_NULL. The underlying communicators are cached and only rebuilt
+ * after bindings change. This routine is collective over the node.
+ *
  * @param[in] q Constructed and initialized QUO_context.
  *
  * @param[in] target_type Target hardware object type.
@@ -617,12 +1448,211 @@ QUO_auto_distrib(QUO_context q,
  *                      freed with a call to MPI_Comm_free.
  *
  * @retval QUO_SUCCESS if the operation completed successfully.
+ *
+ * \code{.c}
+ * MPI_Comm socket_comm;
+ * if (QUO_SUCCESS != QUO_get_mpi_comm_by_type(q, QUO_OBJ_SOCKET,
+ *                                             &socket_comm)) {
+ *     // error handling //
+ * }
+ * if (MPI_COMM_NULL != socket_comm) {
+ *     // socket-local (NUMA-friendly) communication //
+ *     MPI_Comm_free(&socket_comm);
+ * }
+ * \endcode
  */
 int
 QUO_get_mpi_comm_by_type(QUO_context q,
                          QUO_obj_type_t target_type,
                          MPI_Comm *out_comm);
 
+/**
+ * Node-local broadcast. Copies nbytes from the buffer of the process with
+ * node-local ID root_qid into the buffers of all other context-initializing
+ * processes on the node. Data are moved through a shared-memory staging area
+ * (large payloads are pipelined through it in chunks), so this routine is
+ * typically much cheaper than MPI_Bcast over a node communicator. All
+ * context-initializing processes on a node MUST call this with the same nbytes
+ * and root_qid.
+ *
+ * @param[in] q Constructed and initialized QUO_context.
+ *
+ * @param[in,out] buffer Starting address of the buffer. Read at the root,
+ *                       written everywhere else.
+ *
+ * @param[in] nbytes Number of bytes to broadcast.
+ *
+ * @param[in] root_qid Node-local ID (see QUO_id) of the broadcast root.
+ *
+ * @retval QUO_SUCCESS if the operation completed successfully.
+ *
+ * \code{.c}
+ * double table[TABLE_LEN];
+ * if (0 == qid) {
+ *     // populate table //
+ * }
+ * if (QUO_SUCCESS != QUO_node_bcast(q, table, sizeof(table), 0)) {
+ *     // error handling //
+ * }
+ * \endcode
+ */
+int
+QUO_node_bcast(QUO_context q,
+               void *buffer,
+               size_t nbytes,
+               int root_qid);
+
+/**
+ * Node-local allreduce. Combines count elements from the send buffers of all
+ * context-initializing processes on the node and returns the result in every
+ * receive buffer. The reduction is carried out in a shared-memory scratch area:
+ * each process reduces a disjoint slice of the data, so no MPI communication is
+ * involved. All context-initializing processes on a node MUST call this with
+ * the same count, datatype, and op.
+ *
+ * @param[in] q Constructed and initialized QUO_context.
+ *
+ * @param[in] sendbuf Starting address of the send buffer. May be MPI_IN_PLACE
+ *                    (or equal to recvbuf), in which case the input is taken
+ *                    from recvbuf.
+ *
+ * @param[out] recvbuf Starting address of the receive buffer.
+ *
+ * @param[in] count Number of elements in the send buffer.
+ *
+ * @param[in] datatype Element type. One of MPI_INT, MPI_FLOAT, or MPI_DOUBLE.
+ *
+ * @param[in] op Reduction operation. One of MPI_SUM, MPI_MIN, or MPI_MAX.
+ *
+ * @retval QUO_SUCCESS if the operation completed successfully.
+ *
+ * @retval QUO_ERR_NOT_SUPPORTED if the datatype/op pair is not supported.
+ *
+ * \code{.c}
+ * double local_max = compute(), node_max = 0.0;
+ * if (QUO_SUCCESS != QUO_node_allreduce(q, &local_max, &node_max, 1,
+ *                                       MPI_DOUBLE, MPI_MAX)) {
+ *     // error handling //
+ * }
+ * \endcode
+ */
+int
+QUO_node_allreduce(QUO_context q,
+                   const void *sendbuf,
+                   void *recvbuf,
+                   int count,
+                   MPI_Datatype datatype,
+                   MPI_Op op);
+
+/**
+ * Node-local allgather. Every context-initializing process on the node
+ * contributes nbytes from sendbuf; the contributions are returned in every
+ * recvbuf, ordered by node-local ID (QUO_id). Each process writes its
+ * contribution straight into its slot of a shared-memory buffer, so a single
+ * node-local synchronization completes the exchange. All context-initializing
+ * processes on a node MUST call this with the same nbytes.
+ *
+ * @param[in] q Constructed and initialized QUO_context.
+ *
+ * @param[in] sendbuf Starting address of the send buffer.
+ *
+ * @param[in] nbytes Number of bytes contributed by each process.
+ *
+ * @param[out] recvbuf Starting address of the receive buffer. Must be able to
+ *                     hold nbytes * (number of node-local processes) bytes.
+ *
+ * @retval QUO_SUCCESS if the operation completed successfully.
+ *
+ * \code{.c}
+ * int nqids = 0;
+ * if (QUO_SUCCESS != QUO_nqids(q, &nqids)) {
+ *     // error handling //
+ * }
+ * long *all_pids = calloc(nqids, sizeof(*all_pids));
+ * long my_pid = (long)getpid();
+ * if (QUO_SUCCESS != QUO_node_allgather(q, &my_pid, sizeof(my_pid),
+ *                                       all_pids)) {
+ *     // error handling //
+ * }
+ * \endcode
+ */
+int
+QUO_node_allgather(QUO_context q,
+                   const void *sendbuf,
+                   size_t nbytes,
+                   void *recvbuf);
+
+/**
+ * Returns a communicator that contains one "leader" process per hardware
+ * object of the given type across the whole job. Together with the node-local
+ * collectives, this makes hierarchical collectives straightforward: reduce on
+ * the node, exchange among leaders, and broadcast back on the node.
+ *
+ * For QUO_OBJ_MACHINE, the leader of a node is the process with node-local ID
+ * 0. For QUO_OBJ_SOCKET, the leader of a socket is the process with the lowest
+ * node-local ID whose current binding lies entirely within that socket; sockets
+ * without such a process have no leader.
+ *
+ * The communicator is created on first use and cached in the context, so it
+ * MUST NOT be freed by the caller. Socket leadership depends on process
+ * bindings, so a new socket-leader communicator is built after bindings change
+ * (see QUO_bind_push and QUO_bind_pop); previously returned handles remain
+ * valid until QUO_free. This routine is collective over the initializing
+ * communicator.
+ *
+ * @param[in] q Constructed and initialized QUO_context.
+ *
+ * @param[in] type Either QUO_OBJ_MACHINE or QUO_OBJ_SOCKET.
+ *
+ * @param[out] out_comm Leader communicator. MPI_COMM_NULL if the caller is not
+ *                      a leader.
+ *
+ * @retval QUO_SUCCESS if the operation completed successfully.
+ *
+ * @retval QUO_ERR_NOT_SUPPORTED if the provided type is not supported.
+ *
+ * \code{.c}
+ * // node-local reduction followed by a reduction among node leaders //
+ * MPI_Comm leaders;
+ * if (QUO_SUCCESS != QUO_get_leader_comm(q, QUO_OBJ_MACHINE, &leaders)) {
+ *     // error handling //
+ * }
+ * QUO_node_allreduce(q, &val, &node_sum, 1, MPI_DOUBLE, MPI_SUM);
+ * if (MPI_COMM_NULL != leaders) {
+ *     MPI_Allreduce(&node_sum, &sum, 1, MPI_DOUBLE, MPI_SUM, leaders);
+ * }
+ * QUO_node_bcast(q, &sum, sizeof(sum), 0);
+ * \endcode
+ */
+int
+QUO_get_leader_comm(QUO_context q,
+                    QUO_obj_type_t type,
+                    MPI_Comm *out_comm);
+
+/**
+ * Fills in every scalar fact that QUO knows about the caller, its job, and its
+ * node in a single call. All values come from cached state: no communication
+ * and no allocation take place.
+ *
+ * @param[in] q Constructed and initialized QUO_context.
+ *
+ * @param[out] out_info Filled-in information.
+ *
+ * @retval QUO_SUCCESS if the operation completed successfully.
+ *
+ * \code{.c}
+ * QUO_info_t info;
+ * if (QUO_SUCCESS != QUO_query_all(q, &info)) {
+ *     // error handling //
+ * }
+ * printf("%d sockets, %d cores\n", info.nobjs[QUO_OBJ_SOCKET],
+ *        info.nobjs[QUO_OBJ_CORE]);
+ * \endcode
+ */
+int
+QUO_query_all(QUO_context q,
+              QUO_info_t *out_info);
+
 /**
  * \note
  * Experimental.
@@ -82,6 +82,38 @@ QUO_get_mpi_comm_by_type_f2c(QUO_t *q,
     return rc;
 }
 
+/**
+ * Simply a wrapper for our Fortran interface to C interface. No need to expose
+ * in quo.h header at this point, since it is only used by our Fortran module.
+ */
+int
+QUO_node_allreduce_f2c(QUO_t *q,
+                       const void *sendbuf,
+                       void *recvbuf,
+                       int count,
+                       MPI_Fint datatype,
+                       MPI_Fint op)
+{
+    return QUO_node_allreduce(q, sendbuf, recvbuf, count,
+                              MPI_Type_f2c(datatype), MPI_Op_f2c(op));
+}
+
+/**
+ * Simply a wrapper for our Fortran interface to C interface. No need to expose
+ * in quo.h header at this point, since it is only used by our Fortran module.
+ */
+int
+QUO_get_leader_comm_f2c(QUO_t *q,
+                        QUO_obj_type_t type,
+                        MPI_Fint *out_comm)
+{
+    MPI_Comm c_comm = MPI_COMM_NULL;
+    int rc = QUO_get_leader_comm(q, type, &c_comm);
+    *out_comm = MPI_Comm_c2f(c_comm);
+
+    return rc;
+}
+
 /**
  * Used to free up allocated memory on the Fortran side - don't include in
  * quo.h.
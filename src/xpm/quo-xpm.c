@@ -103,26 +103,15 @@ mem_segment_create(quo_xpm_t *xpm)
     int qrc = QUO_SUCCESS;
 
     char *sname = NULL;
-    long long lsize = (long long)xpm->local_size;
-    long long *lsizes = calloc(xpm->qc->nqid, sizeof(*lsizes));
 
-    if (!lsizes) {
-        QUO_OOR_COMPLAIN();
-        qrc = QUO_ERR_OOR;
+    /* Exchange local sizes across all processes on the node (qid order). */
+    if (QUO_SUCCESS != (qrc = quo_mpi_sm_allgather(xpm->qc->mpi,
+                                                   &xpm->local_size,
+                                                   sizeof(xpm->local_size),
+                                                   xpm->local_sizes))) {
+        QUO_ERR_MSGRC("quo_mpi_sm_allgather", qrc);
         goto out;
     }
-    /* Exchange local sizes across all processes in node-local comm. */
-    if (QUO_SUCCESS != (qrc = quo_mpi_allgather(&lsize, 1, MPI_LONG_LONG_INT,
-                                                lsizes, 1, MPI_LONG_LONG_INT,
-                                                xpm->node_comm))) {
-        QUO_ERR_MSGRC("quo_mpi_allgather", qrc);
-        goto out;
-    }
-    /* Copy back. */
-    for (int i = 0; i < xpm->qc->nqid; ++i) {
-        xpm->local_sizes[i] = lsizes[i];
-    }
-    free(lsizes);
 
     xpm->global_size = range_sum(xpm, 0, xpm->qc->nqid - 1);
 
@@ -0,0 +1,649 @@
+/**
+ * Copyright (c) 2013-2016 Los Alamos National Security, LLC
+ *                         All rights reserved.
+ *
+ * This software was produced under U.S. Government contract DE-AC52-06NA25396
+ * for Los Alamos National Laboratory (LANL), which is operated by Los Alamos
+ * National Security, LLC for the U.S.  Department of Energy. The U.S.
+ * Government has rights to use, reproduce, and distribute this software.
+ * NEITHER THE GOVERNMENT NOR LOS ALAMOS NATIONAL SECURITY, LLC MAKES ANY
+ * WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY LIABILITY FOR THE USE OF THIS
+ * SOFTWARE.  If software is modified to produce derivative works, such modified
+ * software should be clearly marked, so as not to confuse it with the version
+ * available from LANL.
+ *
+ * Additionally, redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * · Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * · Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * · Neither the name of Los Alamos National Security, LLC, Los Alamos
+ *   National Laboratory, LANL, the U.S. Government, nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY LOS ALAMOS NATIONAL SECURITY, LLC AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+ * NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL LOS ALAMOS NATIONAL
+ * SECURITY, LLC OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Exercises the node-local collectives.
+ */
+
+#include "quo.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#include "mpi.h"
+
+/* spans a handful of staging slots, so the pipelined path is exercised */
+#define BCAST_MAX_NBYTES (1 << 20)
+
+static void
+check_bcast(QUO_context q,
+            int qid,
+            int nqids)
+{
+    static const size_t sizes[] = {0, 1, 7, 4096, 65536, 65537, 300000,
+                                   BCAST_MAX_NBYTES};
+    static const int nsizes = sizeof(sizes) / sizeof(sizes[0]);
+    unsigned char *buf = malloc(BCAST_MAX_NBYTES);
+    assert(buf);
+
+    for (int i = 0; i < nsizes; ++i) {
+        /* rotate through roots */
+        const int root = i % nqids;
+        for (size_t b = 0; b < sizes[i]; ++b) {
+            buf[b] = (qid == root) ? (unsigned char)(b * 31 + i) : 0xff;
+        }
+        assert(QUO_SUCCESS == QUO_node_bcast(q, buf, sizes[i], root));
+        for (size_t b = 0; b < sizes[i]; ++b) {
+            assert(buf[b] == (unsigned char)(b * 31 + i));
+        }
+    }
+    /* bad roots are rejected */
+    assert(QUO_ERR_INVLD_ARG == QUO_node_bcast(q, buf, 1, nqids));
+    free(buf);
+}
+
+/* contribution of process qid to element i - small integers, so float sums of
+ * them are exact */
+#define CONTRIB(qid, i) (((qid) + 1) * ((int)(i) % 97))
+
+#define CHECK_ALLREDUCE(ctype, mpitype)                                        \
+do {                                                                           \
+    ctype *in = calloc(count, sizeof(ctype));                                  \
+    ctype *out = calloc(count, sizeof(ctype));                                 \
+    assert(in && out);                                                         \
+    for (int i = 0; i < count; ++i) in[i] = (ctype)CONTRIB(qid, i);           \
+    assert(QUO_SUCCESS == QUO_node_allreduce(q, in, out, count, mpitype,       \
+                                             MPI_SUM));                        \
+    for (int i = 0; i < count; ++i) {                                          \
+        assert(out[i] == (ctype)((i % 97) * nqids * (nqids + 1) / 2));        \
+    }                                                                          \
+    assert(QUO_SUCCESS == QUO_node_allreduce(q, in, out, count, mpitype,       \
+                                             MPI_MIN));                        \
+    for (int i = 0; i < count; ++i) assert(out[i] == (ctype)CONTRIB(0, i));   \
+    /* in place */                                                             \
+    assert(QUO_SUCCESS == QUO_node_allreduce(q, MPI_IN_PLACE, in, count,       \
+                                             mpitype, MPI_MAX));               \
+    for (int i = 0; i < count; ++i) {                                          \
+        assert(in[i] == (ctype)CONTRIB(nqids - 1, i));                         \
+    }                                                                          \
+    free(in);                                                                  \
+    free(out);                                                                 \
+} while (0)
+
+static void
+check_allreduce(QUO_context q,
+                int qid,
+                int nqids)
+{
+    /* the last one spans several pieces of the scratch area */
+    static const int counts[] = {0, 1, 3, 1000, 300000};
+    static const int ncounts = sizeof(counts) / sizeof(counts[0]);
+
+    for (int c = 0; c < ncounts; ++c) {
+        const int count = counts[c];
+        CHECK_ALLREDUCE(int, MPI_INT);
+        CHECK_ALLREDUCE(float, MPI_FLOAT);
+        CHECK_ALLREDUCE(double, MPI_DOUBLE);
+    }
+    /* unsupported type/op pairs are rejected */
+    long l = 0;
+    assert(QUO_ERR_NOT_SUPPORTED ==
+           QUO_node_allreduce(q, &l, &l, 1, MPI_LONG, MPI_SUM));
+    assert(QUO_ERR_NOT_SUPPORTED ==
+           QUO_node_allreduce(q, &l, &l, 1, MPI_INT, MPI_PROD));
+}
+
+static void
+check_allgather(QUO_context q,
+                int qid,
+                int nqids)
+{
+    /* the last one spans several rounds through the scratch area */
+    static const size_t sizes[] = {0, 1, sizeof(int), 1000, 200000};
+    static const int nsizes = sizeof(sizes) / sizeof(sizes[0]);
+
+    for (int i = 0; i < nsizes; ++i) {
+        const size_t n = sizes[i];
+        unsigned char *in = malloc(n + 1), *out = malloc(n * nqids + 1);
+        assert(in && out);
+        for (size_t b = 0; b < n; ++b) in[b] = (unsigned char)(qid * 7 + b);
+        assert(QUO_SUCCESS == QUO_node_allgather(q, in, n, out));
+        for (int r = 0; r < nqids; ++r) {
+            for (size_t b = 0; b < n; ++b) {
+                assert(out[r * n + b] == (unsigned char)(r * 7 + b));
+            }
+        }
+        free(in);
+        free(out);
+    }
+}
+
+static void
+check_leader_comm(QUO_context q,
+                  int qid)
+{
+    MPI_Comm leaders = MPI_COMM_NULL, again = MPI_COMM_NULL;
+    int nnodes = 0, nsockets = 0;
+
+    assert(QUO_SUCCESS == QUO_nnodes(q, &nnodes));
+    assert(QUO_SUCCESS == QUO_get_leader_comm(q, QUO_OBJ_MACHINE, &leaders));
+    assert((0 == qid) == (MPI_COMM_NULL != leaders));
+    if (MPI_COMM_NULL != leaders) {
+        int nleaders = 0;
+        assert(MPI_SUCCESS == MPI_Comm_size(leaders, &nleaders));
+        assert(nnodes == nleaders);
+    }
+    /* cached */
+    assert(QUO_SUCCESS == QUO_get_leader_comm(q, QUO_OBJ_MACHINE, &again));
+    assert(again == leaders);
+    /* socket leaders: the lowest qid bound to each socket */
+    assert(QUO_SUCCESS == QUO_nsockets(q, &nsockets));
+    if (0 == nsockets) return;
+    const int my_socket = qid % nsockets;
+    char *before = NULL, *after = NULL;
+    assert(QUO_SUCCESS == QUO_stringify_cbind(q, &before));
+    assert(QUO_SUCCESS == QUO_bind_push(q, QUO_BIND_PUSH_PROVIDED,
+                                        QUO_OBJ_SOCKET, my_socket));
+    assert(QUO_SUCCESS == QUO_stringify_cbind(q, &after));
+    assert(QUO_SUCCESS == QUO_get_leader_comm(q, QUO_OBJ_SOCKET, &leaders));
+    assert((qid < nsockets) == (MPI_COMM_NULL != leaders));
+    assert(QUO_SUCCESS == QUO_bind_pop(q));
+    assert(QUO_SUCCESS == QUO_get_leader_comm(q, QUO_OBJ_SOCKET, &again));
+    /* if bindings changed, expect a rebuild. otherwise, the cached one. */
+    if (strcmp(before, after)) {
+        assert(MPI_COMM_NULL == again || again != leaders);
+    }
+    else {
+        assert(again == leaders);
+    }
+    free(before);
+    free(after);
+}
+
+static void
+check_cache_types(QUO_context q)
+{
+    static const QUO_obj_type_t types[] = {QUO_OBJ_L1CACHE, QUO_OBJ_L2CACHE,
+                                           QUO_OBJ_L3CACHE, QUO_OBJ_GROUP};
+    int npus = 0;
+
+    assert(QUO_SUCCESS == QUO_npus(q, &npus));
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); ++i) {
+        int n = 0, npus_in = 0;
+        /* not every machine has every level */
+        assert(QUO_SUCCESS == QUO_nobjs_by_type(q, types[i], &n));
+        for (int o = 0; o < n; ++o) {
+            int ni = 0;
+            assert(QUO_SUCCESS == QUO_nobjs_in_type_by_type(q, types[i], o,
+                                                            QUO_OBJ_PU, &ni));
+            npus_in += ni;
+        }
+        /* caches and groups at one level partition the PUs */
+        assert(0 == n || npus == npus_in);
+        if (0 == n) continue;
+        assert(QUO_SUCCESS == QUO_bind_push(q, QUO_BIND_PUSH_OBJ, types[i], -1));
+        assert(QUO_SUCCESS == QUO_bind_pop(q));
+    }
+}
+
+static void
+check_bind_push_cpuset(QUO_context q)
+{
+    char *before = NULL, *after = NULL;
+    int npus = 0;
+    const QUO_obj_type_t types[2] = {QUO_OBJ_MACHINE, QUO_OBJ_PU};
+    int indices[2] = {0, 0};
+
+    assert(QUO_SUCCESS == QUO_stringify_cbind(q, &before));
+    /* round trip through the mask format */
+    assert(QUO_SUCCESS == QUO_bind_push_cpuset(q, before));
+    assert(QUO_SUCCESS == QUO_stringify_cbind(q, &after));
+    assert(0 == strcmp(before, after));
+    free(after);
+    assert(QUO_SUCCESS == QUO_bind_pop(q));
+    /* the machine's cpuset covers every PU */
+    assert(QUO_SUCCESS == QUO_bind_push_objs(q, types, indices, 2));
+    assert(QUO_SUCCESS == QUO_bind_pop(q));
+    /* bad input */
+    assert(QUO_SUCCESS == QUO_npus(q, &npus));
+    indices[1] = npus;
+    assert(QUO_ERR_INVLD_ARG == QUO_bind_push_objs(q, types, indices, 2));
+    assert(QUO_ERR_INVLD_ARG == QUO_bind_push_objs(q, types, indices, 0));
+    assert(QUO_ERR_INVLD_ARG == QUO_bind_push_cpuset(q, "not-a-cpuset"));
+    assert(QUO_ERR_INVLD_ARG == QUO_bind_push_cpuset(q, "100000"));
+    assert(QUO_ERR_INVLD_ARG == QUO_bind_push_cpuset(q, ""));
+    /* nothing was pushed by any of the failures */
+    assert(QUO_SUCCESS == QUO_stringify_cbind(q, &after));
+    assert(0 == strcmp(before, after));
+    free(before);
+    free(after);
+}
+
+static int
+cbind_npus(QUO_context q)
+{
+    QUO_info_t info;
+    int n = 0;
+
+    assert(QUO_SUCCESS == QUO_query_all(q, &info));
+    for (int i = 0; i < QUO_INFO_CPUSET_NWORDS; ++i) {
+        n += __builtin_popcountll(info.cpuset[i]);
+    }
+    return n;
+}
+
+static void
+check_smt_policy(QUO_context q)
+{
+    int ncores = 0, npus = 0;
+
+    assert(QUO_ERR_INVLD_ARG == QUO_set_smt_policy(q, (QUO_smt_policy_t)42));
+    assert(QUO_SUCCESS == QUO_ncores(q, &ncores));
+    assert(QUO_SUCCESS == QUO_npus(q, &npus));
+    /* a core shrinks to one PU, the machine to one PU per core */
+    assert(QUO_SUCCESS == QUO_set_smt_policy(q, QUO_SMT_ONE_PU_PER_CORE));
+    assert(QUO_SUCCESS == QUO_bind_push(q, QUO_BIND_PUSH_PROVIDED,
+                                        QUO_OBJ_CORE, 0));
+    assert(1 == cbind_npus(q));
+    /* the only PU we have: this does not move the calling thread */
+    int rc = QUO_bind_thread(q, 0, 1);
+    assert(QUO_SUCCESS == rc || QUO_ERR_NOT_SUPPORTED == rc);
+    assert(QUO_ERR_INVLD_ARG == QUO_bind_thread(q, 1, 1));
+    assert(QUO_ERR_INVLD_ARG == QUO_bind_thread(q, -1, 2));
+    /* one core cannot take two threads with this policy */
+    assert(QUO_ERR_INVLD_ARG == QUO_bind_thread(q, 1, 2));
+    assert(QUO_SUCCESS == QUO_bind_push(q, QUO_BIND_PUSH_PROVIDED,
+                                        QUO_OBJ_MACHINE, 0));
+    if (npus <= 64 * QUO_INFO_CPUSET_NWORDS) assert(ncores == cbind_npus(q));
+    assert(QUO_SUCCESS == QUO_bind_pop(q));
+    assert(QUO_SUCCESS == QUO_bind_pop(q));
+    /* back to the default: every PU of the core */
+    assert(QUO_SUCCESS == QUO_set_smt_policy(q, QUO_SMT_CORES_FIRST));
+    assert(QUO_SUCCESS == QUO_bind_push(q, QUO_BIND_PUSH_PROVIDED,
+                                        QUO_OBJ_CORE, 0));
+    int core_npus = 0;
+    assert(QUO_SUCCESS == QUO_nobjs_in_type_by_type(q, QUO_OBJ_CORE, 0,
+                                                    QUO_OBJ_PU, &core_npus));
+    if (npus <= 64 * QUO_INFO_CPUSET_NWORDS) assert(core_npus == cbind_npus(q));
+    assert(QUO_SUCCESS == QUO_bind_pop(q));
+}
+
+static void
+check_membind(QUO_context q)
+{
+    /* nothing to pop yet */
+    assert(QUO_ERR_POP == QUO_membind_pop(q));
+    assert(QUO_ERR_INVLD_ARG == QUO_membind_push(q, ~QUO_MEMBIND_STRICT));
+    int rc = QUO_membind_push(q, QUO_MEMBIND_NONE);
+    if (QUO_ERR_NOT_SUPPORTED == rc) return;
+    assert(QUO_SUCCESS == rc);
+    /* same nodes again: still needs its own pop */
+    assert(QUO_SUCCESS == QUO_membind_push(q, QUO_MEMBIND_NONE));
+    assert(QUO_SUCCESS == QUO_membind_pop(q));
+    assert(QUO_SUCCESS == QUO_membind_pop(q));
+    assert(QUO_ERR_POP == QUO_membind_pop(q));
+    /* migrate the whole process, then just a registered buffer */
+    size_t nbytes = 1, len = 1 << 20;
+    double secs = -1.0;
+    char *buf = malloc(len);
+    assert(buf);
+    memset(buf, 1, len);
+    assert(QUO_SUCCESS == QUO_membind_push(q, QUO_MEMBIND_MIGRATE));
+    assert(QUO_SUCCESS == QUO_membind_migrate_stats(q, &nbytes, &secs));
+    assert(secs >= 0.0);
+    assert(QUO_SUCCESS == QUO_membind_pop(q));
+    assert(QUO_SUCCESS == QUO_membind_register(q, buf, len));
+    assert(QUO_SUCCESS == QUO_membind_push(q, QUO_MEMBIND_MIGRATE));
+    assert(QUO_SUCCESS == QUO_membind_migrate_stats(q, &nbytes, &secs));
+    assert(nbytes <= len + 4096 && secs >= 0.0);
+    assert(QUO_SUCCESS == QUO_membind_pop(q));
+    assert(QUO_SUCCESS == QUO_membind_unregister(q, buf));
+    assert(QUO_ERR_NOT_FOUND == QUO_membind_unregister(q, buf));
+    free(buf);
+}
+
+static void
+check_bind_stack(QUO_context q)
+{
+    char *before = NULL, *after = NULL;
+    /* deeper than the bind stack pool's initial size (and the old fixed cap) */
+    const int depth = 200;
+
+    assert(QUO_SUCCESS == QUO_stringify_cbind(q, &before));
+    for (int i = 0; i < depth; ++i) {
+        assert(QUO_SUCCESS == QUO_bind_push(q, QUO_BIND_PUSH_PROVIDED,
+                                            QUO_OBJ_MACHINE, 0));
+        assert(QUO_SUCCESS == QUO_bind_push(q, QUO_BIND_PUSH_OBJ,
+                                            QUO_OBJ_MACHINE, -1));
+    }
+    for (int i = 0; i < 2 * depth; ++i) {
+        assert(QUO_SUCCESS == QUO_bind_pop(q));
+    }
+    assert(QUO_SUCCESS == QUO_stringify_cbind(q, &after));
+    assert(0 == strcmp(before, after));
+    free(before);
+    free(after);
+}
+
+static void
+check_comm_by_type(QUO_context q,
+                   int qid)
+{
+    static const QUO_obj_type_t types[] = {QUO_OBJ_SOCKET, QUO_OBJ_NUMANODE,
+                                           QUO_OBJ_CORE};
+    MPI_Comm comm = MPI_COMM_NULL;
+
+    for (unsigned t = 0; t < sizeof(types) / sizeof(types[0]); ++t) {
+        int nobjs = 0;
+        assert(QUO_SUCCESS == QUO_nobjs_by_type(q, types[t], &nobjs));
+        if (0 == nobjs) continue;
+        const int my_obj = qid % nobjs;
+        assert(QUO_SUCCESS == QUO_bind_push(q, QUO_BIND_PUSH_PROVIDED,
+                                            types[t], my_obj));
+        assert(QUO_SUCCESS == QUO_get_mpi_comm_by_type(q, types[t], &comm));
+        assert(MPI_COMM_NULL != comm);
+        /* everyone in my communicator is bound within my object */
+        int nmembers = 0, *objs = NULL;
+        assert(MPI_SUCCESS == MPI_Comm_size(comm, &nmembers));
+        assert((objs = calloc(nmembers, sizeof(*objs))));
+        assert(MPI_SUCCESS == MPI_Allgather(&my_obj, 1, MPI_INT, objs, 1,
+                                            MPI_INT, comm));
+        for (int i = 0; i < nmembers; ++i) assert(my_obj == objs[i]);
+        free(objs);
+        assert(MPI_SUCCESS == MPI_Comm_free(&comm));
+        /* the cached version is handed out again */
+        assert(QUO_SUCCESS == QUO_get_mpi_comm_by_type(q, types[t], &comm));
+        assert(MPI_COMM_NULL != comm);
+        assert(MPI_SUCCESS == MPI_Comm_free(&comm));
+        assert(QUO_SUCCESS == QUO_bind_pop(q));
+    }
+}
+
+static void
+check_qids_in_type(QUO_context q,
+                   int qid,
+                   int nqids)
+{
+    int ncores = 0, n = 0, *qids = NULL;
+
+    /* everyone is within the machine */
+    assert(QUO_SUCCESS == QUO_qids_in_type(q, QUO_OBJ_MACHINE, 0, &n, &qids));
+    assert(nqids == n);
+    for (int i = 0; i < n; ++i) assert(i == qids[i]);
+    free(qids);
+    /* published bindings follow pushes and pops */
+    assert(QUO_SUCCESS == QUO_nobjs_by_type(q, QUO_OBJ_CORE, &ncores));
+    if (0 == ncores) return;
+    const int my_core = qid % ncores;
+    assert(QUO_SUCCESS == QUO_bind_push(q, QUO_BIND_PUSH_PROVIDED,
+                                        QUO_OBJ_CORE, my_core));
+    assert(QUO_SUCCESS == QUO_barrier(q));
+    assert(QUO_SUCCESS == QUO_qids_in_type(q, QUO_OBJ_CORE, my_core,
+                                           &n, &qids));
+    bool found = false;
+    for (int i = 0; i < n; ++i) {
+        assert(my_core == qids[i] % ncores);
+        if (qid == qids[i]) found = true;
+    }
+    assert(found);
+    /* the allocation-free flavors agree */
+    int nbuf = 0, *buf = NULL;
+    QUO_qid_mask_t mask, all;
+    assert((buf = calloc(nqids, sizeof(*buf))));
+    assert(QUO_SUCCESS == QUO_qids_in_type_buf(q, QUO_OBJ_CORE, my_core,
+                                               nqids, &nbuf, buf));
+    assert(QUO_SUCCESS == QUO_qids_in_type_mask(q, QUO_OBJ_CORE, my_core,
+                                                &mask));
+    assert(n == nbuf && n == QUO_qid_mask_popcount(&mask));
+    int i = 0;
+    for (int id = QUO_qid_mask_next(&mask, -1); id != -1;
+         id = QUO_qid_mask_next(&mask, id), ++i) {
+        assert(qids[i] == id && buf[i] == id);
+    }
+    assert(n == i);
+    assert(QUO_SUCCESS == QUO_qids_in_type_mask(q, QUO_OBJ_MACHINE, 0, &all));
+    assert(nqids == QUO_qid_mask_popcount(&all));
+    QUO_qid_mask_and(&all, &all, &mask);
+    assert(n == QUO_qid_mask_popcount(&all));
+    QUO_qid_mask_zero(&all);
+    QUO_qid_mask_set(&all, nqids - 1);
+    QUO_qid_mask_or(&all, &all, &mask);
+    assert(QUO_qid_mask_isset(&all, nqids - 1));
+    assert(QUO_qid_mask_isset(&all, qid));
+    free(buf);
+    free(qids);
+    assert(QUO_SUCCESS == QUO_barrier(q));
+    assert(QUO_SUCCESS == QUO_bind_pop(q));
+    assert(QUO_SUCCESS == QUO_barrier(q));
+}
+
+static void
+check_auto_distrib(QUO_context q,
+                   int qid,
+                   int nqids)
+{
+    const int max = 2;
+    int nsockets = 0, selected = 0, sel = 0, res = -1, n = 0, *qids = NULL;
+
+    assert(QUO_SUCCESS == QUO_nobjs_by_type(q, QUO_OBJ_SOCKET, &nsockets));
+    if (0 == nsockets) return;
+    assert(QUO_SUCCESS == QUO_barrier(q));
+    assert(QUO_SUCCESS == QUO_auto_distrib(q, QUO_OBJ_SOCKET, max, &selected));
+    assert(QUO_SUCCESS == QUO_auto_distrib_assign(q, QUO_OBJ_SOCKET, max,
+                                                  &sel, &res,
+                                                  QUO_AUTO_DISTRIB_NONE));
+    assert(sel == selected);
+    assert(sel ? (0 <= res && res < nsockets) : -1 == res);
+    const int res0 = res;
+    /* everyone gets the same node-wide map, with themselves in it */
+    int *map = NULL, *map0 = NULL;
+    assert((map = calloc(nqids, sizeof(*map))));
+    assert((map0 = calloc(nqids, sizeof(*map0))));
+    assert(QUO_SUCCESS == QUO_auto_distrib_get_map(q, map));
+    assert(res == map[qid]);
+    memcpy(map0, map, nqids * sizeof(*map));
+    assert(QUO_SUCCESS == QUO_node_bcast(q, map0, nqids * sizeof(*map0), 0));
+    assert(0 == memcmp(map, map0, nqids * sizeof(*map)));
+    free(map);
+    free(map0);
+    /* no resource gets more than max */
+    int *in_res = NULL, *node_in_res = NULL;
+    assert((in_res = calloc(nsockets, sizeof(*in_res))));
+    assert((node_in_res = calloc(nsockets, sizeof(*node_in_res))));
+    if (sel) in_res[res] = 1;
+    assert(QUO_SUCCESS == QUO_node_allreduce(q, in_res, node_in_res, nsockets,
+                                             MPI_INT, MPI_SUM));
+    for (int i = 0; i < nsockets; ++i) assert(node_in_res[i] <= max);
+    free(in_res);
+    free(node_in_res);
+    /* binding lands the caller on its resource */
+    assert(QUO_SUCCESS == QUO_barrier(q));
+    assert(QUO_SUCCESS == QUO_auto_distrib_assign(q, QUO_OBJ_SOCKET, max,
+                                                  &sel, &res,
+                                                  QUO_AUTO_DISTRIB_BIND));
+    assert(sel == selected);
+    if (sel) {
+        assert(QUO_SUCCESS == QUO_qids_in_type(q, QUO_OBJ_SOCKET, res,
+                                               &n, &qids));
+        bool found = false;
+        for (int i = 0; i < n; ++i) {
+            if (qid == qids[i]) found = true;
+        }
+        assert(found);
+        free(qids);
+        assert(QUO_SUCCESS == QUO_bind_pop(q));
+    }
+    /* back to the bindings of the first call, so back to its answer */
+    assert(QUO_SUCCESS == QUO_auto_distrib_assign(q, QUO_OBJ_SOCKET, max,
+                                                  &sel, &res,
+                                                  QUO_AUTO_DISTRIB_NONE));
+    assert(sel == selected && res == res0);
+    /* minimum-migration fills every slot. no barrier: the selected just
+     * popped their bindings, and everyone must still agree on the map. */
+    int nsel = 0;
+    assert(QUO_SUCCESS ==
+           QUO_auto_distrib_assign(q, QUO_OBJ_SOCKET, 1, &sel, &res,
+                                   QUO_AUTO_DISTRIB_MIN_MIGRATION));
+    assert(sel ? (0 <= res && res < nsockets) : -1 == res);
+    assert(QUO_SUCCESS == QUO_node_allreduce(q, &sel, &nsel, 1, MPI_INT,
+                                             MPI_SUM));
+    assert(nsel == (nqids < nsockets ? nqids : nsockets));
+    /* nested: one per socket, then one per core within that socket */
+    const QUO_obj_type_t levels[2] = {QUO_OBJ_SOCKET, QUO_OBJ_CORE};
+    const int maxes[2] = {1, 1};
+    assert(QUO_SUCCESS == QUO_auto_distrib_hier(q, levels, maxes, 2, &sel,
+                                                &res, QUO_AUTO_DISTRIB_BIND));
+    assert(QUO_SUCCESS == QUO_node_allreduce(q, &sel, &nsel, 1, MPI_INT,
+                                             MPI_SUM));
+    assert(nsel == (nqids < nsockets ? nqids : nsockets));
+    if (sel) {
+        int ncores = 0;
+        assert(QUO_SUCCESS == QUO_nobjs_by_type(q, QUO_OBJ_CORE, &ncores));
+        assert(0 <= res && res < ncores);
+        assert(QUO_SUCCESS == QUO_bind_pop(q));
+    }
+    const QUO_obj_type_t same[2] = {QUO_OBJ_SOCKET, QUO_OBJ_SOCKET};
+    assert(QUO_ERR_INVLD_ARG ==
+           QUO_auto_distrib_hier(q, same, maxes, 2, &sel, &res,
+                                 QUO_AUTO_DISTRIB_NONE));
+    /* one active per socket by default, each filling its socket */
+    QUO_placement_t place;
+    int npus = 0;
+    assert(QUO_SUCCESS == QUO_npus(q, &npus));
+    assert(QUO_SUCCESS == QUO_barrier(q));
+    assert(QUO_SUCCESS == QUO_global_place(q, QUO_OBJ_SOCKET, 0,
+                                           QUO_AUTO_DISTRIB_NONE, &place));
+    assert(place.nactive_on_node == (nqids < nsockets ? nqids : nsockets));
+    assert(QUO_SUCCESS == QUO_node_allreduce(q, &place.active, &nsel, 1,
+                                             MPI_INT, MPI_SUM));
+    assert(nsel == place.nactive_on_node);
+    if (place.active) {
+        assert(0 <= place.res_index && place.res_index < nsockets);
+        assert(1 <= place.nthreads && place.nthreads <= npus);
+    }
+    else assert(-1 == place.res_index && 0 == place.nthreads);
+    /* an explicit job-wide count goes to the nodes with the most PUs each */
+    int nnodes = 0, nnode_active = 0;
+    assert(QUO_SUCCESS == QUO_nnodes(q, &nnodes));
+    assert(QUO_SUCCESS == QUO_global_place(q, QUO_OBJ_SOCKET, nnodes,
+                                           QUO_AUTO_DISTRIB_NONE, &place));
+    assert(place.nactive == nnodes);
+    assert(1 == place.nactive_on_node);
+    assert(QUO_SUCCESS == QUO_node_allreduce(q, &place.active, &nsel, 1,
+                                             MPI_INT, MPI_SUM));
+    assert(1 == nsel);
+    assert(QUO_SUCCESS == QUO_global_place(q, QUO_OBJ_SOCKET, nnodes * nqids,
+                                           QUO_AUTO_DISTRIB_NONE, &place));
+    assert(place.nactive_on_node == nqids);
+    assert(QUO_SUCCESS == QUO_node_allreduce(q, &place.active, &nnode_active,
+                                             1, MPI_INT, MPI_SUM));
+    assert(nnode_active == nqids);
+    assert(1 <= place.nthreads && place.nthreads <= npus);
+    /* costliest first: with one slot per socket, the top nsockets costs win */
+    assert(QUO_SUCCESS == QUO_barrier(q));
+    assert(QUO_SUCCESS == QUO_auto_distrib_weighted(q, QUO_OBJ_SOCKET, 1,
+                                                    (double)qid, &sel, &res,
+                                                    QUO_AUTO_DISTRIB_NONE));
+    assert(sel == (qid >= nqids - nsockets));
+    assert(sel ? (0 <= res && res < nsockets) : -1 == res);
+    /* one bad cost fails everyone */
+    assert(QUO_ERR_INVLD_ARG ==
+           QUO_auto_distrib_weighted(q, QUO_OBJ_SOCKET, 1,
+                                     (nqids - 1 == qid) ? -1.0 : 1.0,
+                                     &sel, &res, QUO_AUTO_DISTRIB_NONE));
+    assert(QUO_SUCCESS == QUO_barrier(q));
+}
+
+static void
+check_rebalance(QUO_context q,
+                int nqids)
+{
+    int max = 1, sel = 0, res = -1, nsockets = 0;
+
+    assert(QUO_SUCCESS == QUO_nobjs_by_type(q, QUO_OBJ_SOCKET, &nsockets));
+    if (0 == nsockets) return;
+    const int max_max = (nqids + nsockets - 1) / nsockets;
+    /* the phase gets faster with every extra process, so max has to climb */
+    for (int step = 0; step < 2 * max_max; ++step) {
+        assert(QUO_SUCCESS == QUO_rebalance(q, QUO_OBJ_SOCKET, 3, &max, &sel,
+                                            &res, QUO_AUTO_DISTRIB_NONE));
+        assert(1 <= max && max <= max_max);
+        if (sel) assert(QUO_SUCCESS == QUO_phase_report(q, 3, 1.0 / max));
+    }
+    assert(max_max == max);
+    assert(QUO_ERR_INVLD_ARG == QUO_phase_report(q, QUO_MAX_PHASES, 1.0));
+    assert(QUO_ERR_INVLD_ARG == QUO_phase_report(q, 0, -1.0));
+}
+
+int
+main(int argc, char **argv)
+{
+    QUO_context q = NULL;
+    int qid = 0, nqids = 0;
+
+    assert(MPI_SUCCESS == MPI_Init(&argc, &argv));
+    assert(QUO_SUCCESS == QUO_create(&q, MPI_COMM_WORLD));
+    assert(QUO_SUCCESS == QUO_id(q, &qid));
+    assert(QUO_SUCCESS == QUO_nqids(q, &nqids));
+
+    check_bcast(q, qid, nqids);
+    check_allreduce(q, qid, nqids);
+    check_allgather(q, qid, nqids);
+    check_leader_comm(q, qid);
+    check_bind_stack(q);
+    check_bind_push_cpuset(q);
+    check_cache_types(q);
+    check_smt_policy(q);
+    check_membind(q);
+    check_comm_by_type(q, qid);
+    check_qids_in_type(q, qid, nqids);
+    check_auto_distrib(q, qid, nqids);
+    check_rebalance(q, nqids);
+
+    assert(QUO_SUCCESS == QUO_free(q));
+    assert(MPI_SUCCESS == MPI_Finalize());
+    return EXIT_SUCCESS;
+}
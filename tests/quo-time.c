@@ -17,6 +17,11 @@
 
 #include "mpi.h"
 
+/** Payload size (in B) used by the node-local collective timings. */
+#define NODE_COLL_NBYTES (1 << 20)
+/** Number of doubles used by the node-local reduction timings. */
+#define NODE_COLL_NDOUBLES 1024
+
 /**
  * Measures operational latencies of QUO calls.
  */
@@ -157,6 +162,26 @@ qnpus(
     return 0;
 }
 
+static int
+qnobjs_in_type_by_type(
+    context_t *c,
+    int n_trials,
+    double *res
+) {
+    int n = 0;
+    for (int i = 0; i < n_trials; ++i) {
+        double start = MPI_Wtime();
+        if (QUO_SUCCESS != QUO_nobjs_in_type_by_type(
+                               c->quo, QUO_OBJ_MACHINE, 0,
+                               QUO_OBJ_PU, &n)) return 1;
+        double end = MPI_Wtime();
+        res[i] = end - start;
+    }
+    // Don't want compiler to optimize this away. Will never print.
+    if (c->rank == (c->nranks + 1)) printf("%d\n", n);
+    return 0;
+}
+
 static int
 qquids_in_type(
     context_t *c,
@@ -254,6 +279,144 @@ qbarrier(
     return 0;
 }
 
+static int
+qnode_bcast(
+    context_t *c,
+    int n_trials,
+    double *res
+) {
+    char *buf = calloc(NODE_COLL_NBYTES, sizeof(*buf));
+    if (!buf) return 1;
+    //
+    for (int i = 0; i < n_trials; ++i) {
+        double start = MPI_Wtime();
+        if (QUO_SUCCESS != QUO_node_bcast(c->quo, buf,
+                                          NODE_COLL_NBYTES, 0)) return 1;
+        double end = MPI_Wtime();
+        res[i] = end - start;
+    }
+    free(buf);
+    return 0;
+}
+
+static int
+mpi_node_bcast(
+    context_t *c,
+    int n_trials,
+    double *res
+) {
+    MPI_Comm node_comm;
+    if (QUO_SUCCESS != QUO_get_mpi_comm_by_type(c->quo, QUO_OBJ_MACHINE,
+                                                &node_comm)) return 1;
+    char *buf = calloc(NODE_COLL_NBYTES, sizeof(*buf));
+    if (!buf) return 1;
+    //
+    for (int i = 0; i < n_trials; ++i) {
+        double start = MPI_Wtime();
+        if (MPI_SUCCESS != MPI_Bcast(buf, NODE_COLL_NBYTES, MPI_CHAR, 0,
+                                     node_comm)) return 1;
+        double end = MPI_Wtime();
+        res[i] = end - start;
+    }
+    free(buf);
+    MPI_Comm_free(&node_comm);
+    return 0;
+}
+
+static int
+qnode_allreduce(
+    context_t *c,
+    int n_trials,
+    double *res
+) {
+    double in[NODE_COLL_NDOUBLES], out[NODE_COLL_NDOUBLES];
+    for (int i = 0; i < NODE_COLL_NDOUBLES; ++i) in[i] = (double)i;
+    //
+    for (int i = 0; i < n_trials; ++i) {
+        double start = MPI_Wtime();
+        if (QUO_SUCCESS != QUO_node_allreduce(c->quo, in, out,
+                                              NODE_COLL_NDOUBLES,
+                                              MPI_DOUBLE, MPI_SUM)) return 1;
+        double end = MPI_Wtime();
+        res[i] = end - start;
+    }
+    return 0;
+}
+
+static int
+mpi_node_allreduce(
+    context_t *c,
+    int n_trials,
+    double *res
+) {
+    MPI_Comm node_comm;
+    if (QUO_SUCCESS != QUO_get_mpi_comm_by_type(c->quo, QUO_OBJ_MACHINE,
+                                                &node_comm)) return 1;
+    double in[NODE_COLL_NDOUBLES], out[NODE_COLL_NDOUBLES];
+    for (int i = 0; i < NODE_COLL_NDOUBLES; ++i) in[i] = (double)i;
+    //
+    for (int i = 0; i < n_trials; ++i) {
+        double start = MPI_Wtime();
+        if (MPI_SUCCESS != MPI_Allreduce(in, out, NODE_COLL_NDOUBLES,
+                                         MPI_DOUBLE, MPI_SUM,
+                                         node_comm)) return 1;
+        double end = MPI_Wtime();
+        res[i] = end - start;
+    }
+    MPI_Comm_free(&node_comm);
+    return 0;
+}
+
+static int
+qnode_allgather(
+    context_t *c,
+    int n_trials,
+    double *res
+) {
+    int nqids = 0;
+    if (QUO_SUCCESS != QUO_nqids(c->quo, &nqids)) return 1;
+    long *pids = calloc(nqids, sizeof(*pids));
+    if (!pids) return 1;
+    long my_pid = (long)getpid();
+    //
+    for (int i = 0; i < n_trials; ++i) {
+        double start = MPI_Wtime();
+        if (QUO_SUCCESS != QUO_node_allgather(c->quo, &my_pid, sizeof(my_pid),
+                                              pids)) return 1;
+        double end = MPI_Wtime();
+        res[i] = end - start;
+    }
+    free(pids);
+    return 0;
+}
+
+static int
+mpi_node_allgather(
+    context_t *c,
+    int n_trials,
+    double *res
+) {
+    MPI_Comm node_comm;
+    int nqids = 0;
+    if (QUO_SUCCESS != QUO_get_mpi_comm_by_type(c->quo, QUO_OBJ_MACHINE,
+                                                &node_comm)) return 1;
+    if (MPI_SUCCESS != MPI_Comm_size(node_comm, &nqids)) return 1;
+    long *pids = calloc(nqids, sizeof(*pids));
+    if (!pids) return 1;
+    long my_pid = (long)getpid();
+    //
+    for (int i = 0; i < n_trials; ++i) {
+        double start = MPI_Wtime();
+        if (MPI_SUCCESS != MPI_Allgather(&my_pid, 1, MPI_LONG, pids, 1,
+                                         MPI_LONG, node_comm)) return 1;
+        double end = MPI_Wtime();
+        res[i] = end - start;
+    }
+    free(pids);
+    MPI_Comm_free(&node_comm);
+    return 0;
+}
+
 /**
  *
  */
@@ -384,11 +547,21 @@ main(void)
         {context, "QUO_create",       qcreate,        n_trials, 0, NULL},
         {context, "QUO_free",         qfree,          n_trials, 0, NULL},
         {context, "QUO_npus",         qnpus,          n_trials, 0, NULL},
+        {context, "QUO_nobjs_in_type_by_type", qnobjs_in_type_by_type,
+         n_trials, 0, NULL},
         {context, "QUO_qids_in_type", qquids_in_type, n_trials, 0, NULL},
         {context, "QUO_bind_push",    qbind_push,     n_trials, 0, NULL},
         {context, "QUO_bind_pop",     qbind_pop,      n_trials, 0, NULL},
         {context, "QUO_auto_distrib", qauto_distrib,  n_trials, 0, NULL},
-        {context, "QUO_barrier",      qbarrier,       n_trials, 0, NULL}
+        {context, "QUO_barrier",      qbarrier,       n_trials, 0, NULL},
+        {context, "QUO_node_bcast",   qnode_bcast,    n_trials, 0, NULL},
+        {context, "MPI_Bcast (node)", mpi_node_bcast, n_trials, 0, NULL},
+        {context, "QUO_node_allreduce", qnode_allreduce, n_trials, 0, NULL},
+        {context, "MPI_Allreduce (node)", mpi_node_allreduce,
+         n_trials, 0, NULL},
+        {context, "QUO_node_allgather", qnode_allgather, n_trials, 0, NULL},
+        {context, "MPI_Allgather (node)", mpi_node_allgather,
+         n_trials, 0, NULL}
     };
 
     for (unsigned i = 0; i < sizeof(experiments)/sizeof(experiment_t); ++i) {
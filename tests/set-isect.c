@@ -0,0 +1,192 @@
+/**
+ * Copyright (c) 2013-2016 Los Alamos National Security, LLC
+ *                         All rights reserved.
+ *
+ * This software was produced under U.S. Government contract DE-AC52-06NA25396
+ * for Los Alamos National Laboratory (LANL), which is operated by Los Alamos
+ * National Security, LLC for the U.S.  Department of Energy. The U.S.
+ * Government has rights to use, reproduce, and distribute this software.
+ * NEITHER THE GOVERNMENT NOR LOS ALAMOS NATIONAL SECURITY, LLC MAKES ANY
+ * WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY LIABILITY FOR THE USE OF THIS
+ * SOFTWARE.  If software is modified to produce derivative works, such modified
+ * software should be clearly marked, so as not to confuse it with the version
+ * available from LANL.
+ *
+ * Additionally, redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * · Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * · Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * · Neither the name of Los Alamos National Security, LLC, Los Alamos
+ *   National Laboratory, LANL, the U.S. Government, nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY LOS ALAMOS NATIONAL SECURITY, LLC AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+ * NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL LOS ALAMOS NATIONAL
+ * SECURITY, LLC OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Checks quo_set_get_k_set_intersection against the all-pairs merge it
+ * replaced and times both.
+ */
+
+#include "quo.h"
+#include "quo-set.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+
+/** The original all-pairs merge, kept here as the reference implementation. */
+static int
+naive_k_set_intersection(int nsets,
+                         const int *set_lens,
+                         int **sets,
+                         int **res,
+                         int *res_len)
+{
+    int global_max = -1, ilen = 0;
+    int *big_htab = NULL;
+
+    *res = NULL; *res_len = 0;
+    for (int set = 0; set < nsets; ++set) {
+        for (int elem = 0; elem < set_lens[set]; ++elem) {
+            if (global_max < sets[set][elem]) global_max = sets[set][elem];
+        }
+    }
+    if (global_max < 0) return QUO_SUCCESS;
+    if (NULL == (big_htab = malloc((global_max + 1) * sizeof(int)))) {
+        return QUO_ERR_OOR;
+    }
+    memset(big_htab, -1, (global_max + 1) * sizeof(int));
+    for (int seta = 0; seta < nsets; ++seta) {
+        for (int setb = 0; setb < nsets; ++setb) {
+            int i = 0, j = 0;
+            if (seta == setb) continue;
+            while (i < set_lens[seta] && j < set_lens[setb]) {
+                while (i < set_lens[seta] && sets[seta][i] < sets[setb][j]) ++i;
+                if (i == set_lens[seta]) break;
+                while (j < set_lens[setb] && sets[setb][j] < sets[seta][i]) ++j;
+                if (j == set_lens[setb]) break;
+                if (sets[seta][i] == sets[setb][j]) {
+                    if (-1 == big_htab[sets[seta][i]]) {
+                        big_htab[sets[seta][i]] = sets[seta][i];
+                        ++ilen;
+                    }
+                }
+                ++i; ++j;
+            }
+        }
+    }
+    if (ilen > 0) {
+        if (NULL == (*res = calloc(ilen, sizeof(int)))) {
+            free(big_htab);
+            return QUO_ERR_OOR;
+        }
+        for (int i = 0, j = 0; i < global_max + 1; ++i) {
+            if (-1 != big_htab[i]) (*res)[j++] = big_htab[i];
+        }
+    }
+    *res_len = ilen;
+    free(big_htab);
+    return QUO_SUCCESS;
+}
+
+static double
+now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+/**
+ * nsets sets over qids [0, nqids). Each qid lands in a set with probability
+ * 1/pdenom, so the sets look like qids-per-resource tables.
+ */
+static void
+run(int nsets,
+    int nqids,
+    int pdenom,
+    int ntrials)
+{
+    int *lens = calloc(nsets, sizeof(*lens));
+    int **sets = calloc(nsets, sizeof(*sets));
+    assert(lens && sets);
+
+    for (int s = 0; s < nsets; ++s) {
+        assert((sets[s] = calloc(nqids, sizeof(int))));
+        for (int qid = 0; qid < nqids; ++qid) {
+            if (0 == rand() % pdenom) sets[s][lens[s]++] = qid;
+        }
+    }
+
+    double tnaive = 0.0, tbits = 0.0;
+    for (int t = 0; t < ntrials; ++t) {
+        int *rn = NULL, *rb = NULL, nn = 0, nb = 0;
+        double start = now();
+        assert(QUO_SUCCESS ==
+               naive_k_set_intersection(nsets, lens, sets, &rn, &nn));
+        tnaive += now() - start;
+        start = now();
+        assert(QUO_SUCCESS ==
+               quo_set_get_k_set_intersection(nsets, lens, sets, &rb, &nb));
+        tbits += now() - start;
+        assert(nn == nb);
+        assert(0 == nn || 0 == memcmp(rn, rb, nn * sizeof(int)));
+        free(rn);
+        free(rb);
+    }
+    printf("### nsets %4d nqids %4d: naive %10.2f us, bitmap %8.2f us\n",
+           nsets, nqids, 1e6 * tnaive / ntrials, 1e6 * tbits / ntrials);
+
+    for (int s = 0; s < nsets; ++s) free(sets[s]);
+    free(sets);
+    free(lens);
+}
+
+int
+main(void)
+{
+    int *res = NULL, len = 0;
+
+    srand(42);
+    /* corner cases */
+    int a[] = {0, 3, 64, 130}, b[] = {3, 130, 200}, c[] = {64};
+    int *abc[] = {a, b, c}, lens[] = {4, 3, 1};
+    assert(QUO_SUCCESS == quo_set_get_k_set_intersection(0, lens, abc,
+                                                         &res, &len));
+    assert(0 == len && NULL == res);
+    assert(QUO_SUCCESS == quo_set_get_k_set_intersection(3, lens, abc,
+                                                         &res, &len));
+    assert(3 == len && 3 == res[0] && 64 == res[1] && 130 == res[2]);
+    free(res);
+    int unsorted[] = {2, 1}, *u[] = {unsorted}, ulen[] = {2};
+    assert(QUO_ERR_INVLD_ARG ==
+           quo_set_get_k_set_intersection(1, ulen, u, &res, &len));
+
+    run(4, 16, 2, 100);
+    run(64, 64, 8, 20);
+    run(256, 256, 16, 5);
+    run(512, 512, 32, 2);
+
+    return EXIT_SUCCESS;
+}
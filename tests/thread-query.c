@@ -0,0 +1,131 @@
+/**
+ * Copyright (c) 2013-2016 Los Alamos National Security, LLC
+ *                         All rights reserved.
+ *
+ * This software was produced under U.S. Government contract DE-AC52-06NA25396
+ * for Los Alamos National Laboratory (LANL), which is operated by Los Alamos
+ * National Security, LLC for the U.S.  Department of Energy. The U.S.
+ * Government has rights to use, reproduce, and distribute this software.
+ * NEITHER THE GOVERNMENT NOR LOS ALAMOS NATIONAL SECURITY, LLC MAKES ANY
+ * WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY LIABILITY FOR THE USE OF THIS
+ * SOFTWARE.  If software is modified to produce derivative works, such modified
+ * software should be clearly marked, so as not to confuse it with the version
+ * available from LANL.
+ *
+ * Additionally, redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * · Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * · Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * · Neither the name of Los Alamos National Security, LLC, Los Alamos
+ *   National Laboratory, LANL, the U.S. Government, nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY LOS ALAMOS NATIONAL SECURITY, LLC AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+ * NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL LOS ALAMOS NATIONAL
+ * SECURITY, LLC OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Hammers the read-only queries from many threads while the main thread pushes
+ * and pops bindings.
+ */
+
+#include "quo.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include "mpi.h"
+
+#define NREADERS 4
+#define NPUSHES 200
+
+typedef struct reader_arg_t {
+    QUO_context q;
+    int qid;
+    volatile bool *done;
+} reader_arg_t;
+
+static void *
+reader(void *arg)
+{
+    const reader_arg_t *ra = arg;
+    QUO_context q = ra->q;
+    unsigned long nreads = 0;
+
+    while (!*ra->done || nreads < 100) {
+        int in = 0, bound = 0, npus = 0;
+        char *str = NULL;
+        QUO_qid_mask_t mask;
+        QUO_info_t info;
+
+        /* everyone is always somewhere on the machine */
+        assert(QUO_SUCCESS == QUO_cpuset_in_type(q, QUO_OBJ_MACHINE, 0, &in));
+        assert(in);
+        assert(QUO_SUCCESS == QUO_bound(q, &bound));
+        assert(QUO_SUCCESS == QUO_stringify_cbind(q, &str));
+        assert(str);
+        free(str);
+        assert(QUO_SUCCESS == QUO_npus(q, &npus));
+        assert(npus > 0);
+        assert(QUO_SUCCESS == QUO_qids_in_type_mask(q, QUO_OBJ_MACHINE, 0,
+                                                    &mask));
+        assert(QUO_qid_mask_isset(&mask, ra->qid));
+        assert(QUO_SUCCESS == QUO_query_all(q, &info));
+        assert(info.qid == ra->qid);
+        ++nreads;
+    }
+    return NULL;
+}
+
+int
+main(int argc, char **argv)
+{
+    QUO_context q = NULL;
+    int qid = 0, ncores = 0;
+    volatile bool done = false;
+    pthread_t tids[NREADERS];
+
+    assert(MPI_SUCCESS == MPI_Init(&argc, &argv));
+    assert(QUO_SUCCESS == QUO_create(&q, MPI_COMM_WORLD));
+    assert(QUO_SUCCESS == QUO_id(q, &qid));
+    assert(QUO_SUCCESS == QUO_ncores(q, &ncores));
+
+    reader_arg_t ra = {q, qid, &done};
+    for (int i = 0; i < NREADERS; ++i) {
+        assert(0 == pthread_create(&tids[i], NULL, reader, &ra));
+    }
+    /* push and pop are not thread-safe, so only this thread changes bindings */
+    for (int i = 0; i < NPUSHES; ++i) {
+        assert(QUO_SUCCESS == QUO_bind_push(q, QUO_BIND_PUSH_PROVIDED,
+                                            QUO_OBJ_CORE, i % ncores));
+        assert(QUO_SUCCESS == QUO_bind_pop(q));
+    }
+    done = true;
+    for (int i = 0; i < NREADERS; ++i) {
+        assert(0 == pthread_join(tids[i], NULL));
+    }
+
+    assert(QUO_SUCCESS == QUO_free(q));
+    assert(MPI_SUCCESS == MPI_Finalize());
+    return EXIT_SUCCESS;
+}